@@ -0,0 +1,260 @@
+#include <benchmark/benchmark.h>
+#include "../src/G29.hpp"
+#include "../src/G29BatchDecoder.hpp"
+#include "../src/G29Dispatcher.hpp"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+G29LoopbackTransport::Report makeReport(uint64_t index) {
+    G29LoopbackTransport::Report report = {};
+    report[0] = static_cast<uint8_t>(0x08 | ((index & 1) ? 0x10 : 0x00));
+    report[1] = static_cast<uint8_t>(index >> 3);
+    report[4] = static_cast<uint8_t>(index);
+    report[5] = static_cast<uint8_t>(0x80 + (index >> 8));
+    report[6] = static_cast<uint8_t>(255 - index);
+    report[7] = 0xff;
+    report[8] = 0xff;
+    return report;
+}
+
+std::vector<uint8_t> makeReports(size_t count) {
+    std::mt19937 random(29);
+    std::vector<uint8_t> reports(count * G29BatchDecoder::kReportSize);
+    for (uint8_t& byte : reports) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return reports;
+}
+
+G29* newLoopbackWheel(G29LoopbackTransport** loopback = nullptr) {
+    G29LoopbackTransport* transport = new G29LoopbackTransport();
+    if (loopback) {
+        *loopback = transport;
+    }
+    return new G29(std::unique_ptr<G29Transport>(transport));
+}
+
+} // namespace
+
+static void BM_ProcessReport(benchmark::State& state) {
+    std::unique_ptr<G29> wheel(newLoopbackWheel());
+    if (state.range(0)) {
+        wheel->enableStats();
+    }
+    std::vector<G29LoopbackTransport::Report> reports;
+    for (uint64_t i = 0; i < 256; ++i) {
+        reports.push_back(makeReport(i));
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        wheel->processReport(reports[i++ & 255].data(), G29LoopbackTransport::kReportSize);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessReport)->ArgName("stats")->Arg(0)->Arg(1);
+
+static void BM_UpdateButtonState(benchmark::State& state) {
+    std::unique_ptr<G29> wheel(newLoopbackWheel());
+    G29LoopbackTransport::Report report = makeReport(1);
+    std::vector<uint8_t> bytes(report.begin(), report.end());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wheel->updateButtonState(bytes));
+    }
+}
+BENCHMARK(BM_UpdateButtonState);
+
+static void BM_DecodeButtons(benchmark::State& state) {
+    G29LoopbackTransport::Report report = makeReport(1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(report);
+        benchmark::DoNotOptimize(G29::decodeButtons(report.data()));
+    }
+}
+BENCHMARK(BM_DecodeButtons);
+
+// Dispatch of a report toggling one button, with the given number of handlers
+// spread over the other buttons: the cost should not grow with the count.
+static void BM_Dispatch(benchmark::State& state) {
+    G29Dispatcher dispatcher(static_cast<size_t>(state.range(0)) + 1);
+    uint64_t calls = 0;
+    G29Dispatcher::ButtonHandler count = [](void* context, G29Button, bool, const G29Event&) {
+        ++*static_cast<uint64_t*>(context);
+    };
+    dispatcher.onButton(G29Button::X, G29ButtonEdge::Press, count, &calls);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        G29Button other = static_cast<G29Button>(1 + i % (static_cast<int64_t>(G29Button::Count) - 1));
+        dispatcher.onButton(other, G29ButtonEdge::Press, count, &calls);
+    }
+
+    G29Event events[2] = {};
+    events[0].state.buttons = buttonMask(G29Button::X);
+    events[0].pressed = buttonMask(G29Button::X);
+    events[1].released = buttonMask(G29Button::X);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        dispatcher.dispatch(events[i++ & 1]);
+    }
+    benchmark::DoNotOptimize(calls);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Dispatch)->ArgName("handlers")->Arg(0)->Arg(64)->Arg(1024);
+
+static void BM_GetState(benchmark::State& state) {
+    std::unique_ptr<G29> wheel(newLoopbackWheel());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wheel->getState());
+    }
+}
+BENCHMARK(BM_GetState);
+
+static void BM_GetStateMap(benchmark::State& state) {
+    std::unique_ptr<G29> wheel(newLoopbackWheel());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wheel->getStateMap());
+    }
+}
+BENCHMARK(BM_GetStateMap);
+
+static void BM_IsButtonPressed(benchmark::State& state) {
+    std::unique_ptr<G29> wheel(newLoopbackWheel());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wheel->isButtonPressed(G29Button::RightPaddle));
+    }
+}
+BENCHMARK(BM_IsButtonPressed);
+
+static void BM_IsButtonPressedByName(benchmark::State& state) {
+    std::unique_ptr<G29> wheel(newLoopbackWheel());
+    const std::string name = "RightPaddle";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wheel->isButtonPressed(name));
+    }
+}
+BENCHMARK(BM_IsButtonPressedByName);
+
+static void BM_MakeConstantForceMessage(benchmark::State& state) {
+    float value = 0.25f;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(value);
+        benchmark::DoNotOptimize(G29::makeConstantForceMessage(value));
+    }
+}
+BENCHMARK(BM_MakeConstantForceMessage);
+
+static void BM_MakeAutocenterMessage(benchmark::State& state) {
+    float strength = 0.5f;
+    float rate = 0.05f;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strength);
+        benchmark::DoNotOptimize(G29::makeAutocenterMessage(strength, rate));
+    }
+}
+BENCHMARK(BM_MakeAutocenterMessage);
+
+static void BM_ForceFeedbackConstantAsync(benchmark::State& state) {
+    G29LoopbackTransport* loopback = nullptr;
+    std::unique_ptr<G29> wheel(newLoopbackWheel(&loopback));
+    wheel->startForceFeedbackWriter();
+
+    unsigned step = 0;
+    for (auto _ : state) {
+        wheel->forceFeedbackConstantAsync((step++ % 1000) / 1000.0f);
+    }
+
+    wheel->stopForceFeedbackWriter();
+    state.counters["written"] = static_cast<double>(loopback->writeCount());
+    state.counters["coalesced"] = static_cast<double>(wheel->coalescedCommandCount());
+}
+BENCHMARK(BM_ForceFeedbackConstantAsync);
+
+static void BM_BatchDecode(benchmark::State& state) {
+    const size_t count = 1 << 16;
+    G29DecodeKernel kernel = static_cast<G29DecodeKernel>(state.range(0));
+    if (!G29BatchDecoder::isSupported(kernel)) {
+        state.SkipWithError("Kernel not supported on this CPU");
+        return;
+    }
+
+    std::vector<uint8_t> reports = makeReports(count);
+    std::vector<uint16_t> wheel(count);
+    std::vector<uint8_t> throttle(count), brake(count), clutch(count);
+    std::vector<uint32_t> buttons(count);
+    G29ReportColumns columns = {wheel.data(), throttle.data(), brake.data(), clutch.data(), buttons.data()};
+
+    for (auto _ : state) {
+        G29BatchDecoder::decode(reports.data(), count, columns, kernel);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * reports.size());
+}
+BENCHMARK(BM_BatchDecode)
+    ->Arg(static_cast<int>(G29DecodeKernel::Scalar))
+    ->Arg(static_cast<int>(G29DecodeKernel::SSE2))
+    ->Arg(static_cast<int>(G29DecodeKernel::AVX2));
+
+// Reports decoded per second by the reader thread, with the loopback device
+// producing reports at the given rate (0: as fast as the reader takes them).
+static void BM_EndToEndThroughput(benchmark::State& state) {
+    G29LoopbackTransport* loopback = nullptr;
+    std::unique_ptr<G29> wheel(newLoopbackWheel(&loopback));
+    unsigned rateHz = static_cast<unsigned>(state.range(0));
+
+    loopback->startGenerator([](uint64_t index, G29LoopbackTransport::Report& report) {
+        report = makeReport(index);
+    }, rateHz);
+    wheel->startReader();
+
+    uint32_t before = wheel->getState().reportCount;
+    for (auto _ : state) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    uint32_t decoded = wheel->getState().reportCount - before;
+
+    wheel->stopReader();
+    loopback->stopGenerator();
+
+    state.SetItemsProcessed(decoded);
+    state.counters["dropped"] = static_cast<double>(loopback->droppedCount());
+}
+BENCHMARK(BM_EndToEndThroughput)->Arg(1000)->Arg(0)->Iterations(5)->UseRealTime();
+
+// Time from a report entering the device queue to getState() returning it.
+static void BM_EndToEndLatency(benchmark::State& state) {
+    G29LoopbackTransport* loopback = nullptr;
+    std::unique_ptr<G29> wheel(newLoopbackWheel(&loopback));
+    wheel->startReader();
+
+    uint64_t index = 0;
+    for (auto _ : state) {
+        uint32_t expected = wheel->getState().reportCount + 1;
+        auto start = std::chrono::steady_clock::now();
+        loopback->inject(makeReport(index++));
+        // Yield so that the reader thread gets the CPU even on a single core.
+        while (wheel->getState().reportCount < expected) {
+            std::this_thread::yield();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        state.SetIterationTime(std::chrono::duration<double>(elapsed).count());
+    }
+
+    wheel->stopReader();
+}
+BENCHMARK(BM_EndToEndLatency)->UseManualTime()->Iterations(2000);
+
+BENCHMARK_MAIN();
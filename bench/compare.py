@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Compares two G29Bench JSON results and fails on regressions.
+
+Usage:
+    G29Bench --benchmark_out=current.json --benchmark_out_format=json
+    bench/compare.py bench/baseline.json current.json [--threshold 10]
+
+A benchmark regresses when its throughput (items per second, when it reports
+one) drops, or its real time grows, by more than the threshold in percent.
+Run with --benchmark_repetitions to compare medians instead of single runs.
+Benchmarks present in only one file are listed and ignored.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        results = json.load(file)
+
+    runs = [run for run in results["benchmarks"] if "error_occurred" not in run]
+    medians = {run["run_name"]: run for run in runs if run.get("aggregate_name") == "median"}
+    if medians:
+        return medians
+    return {run["name"]: run for run in runs if run.get("run_type", "iteration") == "iteration"}
+
+
+def slowdown(old, new):
+    """Returns how much slower new is than old, in percent, and the values compared."""
+    if "items_per_second" in old and "items_per_second" in new:
+        before, after = old["items_per_second"], new["items_per_second"]
+        return (before / after - 1.0) * 100.0, before, after, "items/s"
+    before, after = old["real_time"], new["real_time"]
+    return (after / before - 1.0) * 100.0, before, after, new["time_unit"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown, in percent (default: 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    width = max((len(name) for name in baseline), default=0)
+    for name, old in baseline.items():
+        new = current.get(name)
+        if new is None:
+            print(f"{name:<{width}}  missing from {args.current}")
+            continue
+
+        change, before, after, unit = slowdown(old, new)
+        status = ""
+        if change > args.threshold:
+            status = "REGRESSION"
+            regressions += 1
+        print(f"{name:<{width}}  {before:>14.1f} -> {after:>14.1f} {unit:<7}  {change:+7.1f}%  {status}")
+
+    for name in current:
+        if name not in baseline:
+            print(f"{name:<{width}}  new, no baseline")
+
+    if regressions:
+        print(f"{regressions} benchmark(s) slower than {args.threshold}% over the baseline")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
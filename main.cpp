@@ -2,22 +2,18 @@
 #include <iomanip>
 #include "src/G29.hpp" 
 
-void printState(const std::unordered_map<std::string, uint8_t>& state) {
-    std::cout << "Steering: " << static_cast<int>(state.at("steering"))
-              << " | Throttle: " << static_cast<int>(state.at("throttle"))
-              << " | Brake: " << static_cast<int>(state.at("brake"))
-              << " | Clutch: " << static_cast<int>(state.at("clutch")) << std::endl;
+void printState(const G29State& state) {
+    std::cout << "Steering: " << static_cast<int>(state.steering)
+              << " | Throttle: " << static_cast<int>(state.throttle)
+              << " | Brake: " << static_cast<int>(state.brake)
+              << " | Clutch: " << static_cast<int>(state.clutch) << std::endl;
 }
 
-void printButtonStates(const G29& g29) {
-    std::vector<std::string> buttons = {"X", "Square", "Triangle", "Circle", "L2", "R2", "L3", "R3",
-                                        "Share", "Options", "PS", "DPadUp", "DPadRight", "DPadDown", "DPadLeft",
-                                        "PlusButton", "MinusButton", "RotaryDialPress",
-                                        "LeftPaddle", "RightPaddle"};
-
-    for (const auto& button : buttons) {
-        if (g29.isButtonPressed(button)) {
-            std::cout << button << " ";
+void printButtonStates(const G29State& state) {
+    for (size_t i = 0; i < static_cast<size_t>(G29Button::Count); ++i) {
+        G29Button button = static_cast<G29Button>(i);
+        if (state.isPressed(button)) {
+            std::cout << G29::buttonName(button) << " ";
         }
     }
     std::cout << std::endl;
@@ -39,15 +35,14 @@ int main() {
         std::cout << "Starting main loop. Press Ctrl+C to exit." << std::endl;
 
         while (true) {
-            g29.readLoop();  
-            // Get and print the current state
-            auto state = g29.getState();
-            std::cout << "Current state: ";
-            printState(state);
+            // Read everything that arrived since the last frame
+            G29Batch batch = g29.drain();
+            std::cout << "Current state (" << batch.reportCount << " reports): ";
+            printState(batch.state);
 
             // Print pressed buttons
             std::cout << g29.getPressedButton() << std::endl;
-            // printButtonStates(g29);
+            // printButtonStates(batch.state);
 
 
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
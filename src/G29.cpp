@@ -1,60 +1,216 @@
 #include "G29.hpp"
-#include <iostream>
 #include <algorithm>  
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+const int G29::kReadSliceMs;
+const unsigned G29::kForceSlotCount;
+constexpr std::chrono::milliseconds G29::kRevLightsWriteInterval;
+constexpr std::chrono::microseconds G29::kDefaultPredictionHorizon;
+constexpr std::chrono::milliseconds G29::kSettleTime;
+constexpr std::chrono::milliseconds G29::kSweepStartTimeout;
+const int G29::kSettleTolerance;
+constexpr std::chrono::microseconds G29::kMinFilterInterval;
+
+namespace {
+
+const char* const kButtonNames[] = {
+    "X", "Square", "Triangle", "Circle",
+    "L2", "R2", "L3", "R3",
+    "DPadUp", "DPadDown", "DPadLeft", "DPadRight",
+    "RotaryDialPress", "PlusButton", "MinusButton",
+    "LeftPaddle", "RightPaddle",
+    "Share", "Options", "PS",
+};
+
+static_assert(sizeof(kButtonNames) / sizeof(kButtonNames[0]) == static_cast<size_t>(G29Button::Count),
+              "Every button needs a name");
+
+uint64_t toNanoseconds(std::chrono::steady_clock::time_point time) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+} // namespace
+
+G29::G29() : G29(G29WheelModel::g29()) {
+}
+
+G29::G29(const G29WheelModel& model)
+    : G29(std::unique_ptr<G29Transport>(new G29HidapiTransport(model.vendorId, model.productId)), model) {
+}
+
+G29::G29(std::unique_ptr<G29Transport> transport, const G29WheelModel& model)
+    : transport(std::move(transport)), model(model), forceOffGeneration(0), suppressedWrites(0), writerRunning(false),
+      writeInterval(std::chrono::milliseconds(2)), coalescedCommands(0), queuedRevLights(-1), coalescedReports(0),
+      malformedReports(0), readerRunning(false), wakeRequested(false), startupRunning(false), startupCancelled(false) {
+    if (!this->transport) {
+        throw std::invalid_argument("G29 needs a transport");
+    }
+
+    cache.resize(model.reportSize, 0);
+    buttonBits = 0;
+    filtering = false;
+    dispatcher = nullptr;
 
-G29::G29() {
-    if (hid_init() != 0) {
-        throw std::runtime_error("Failed to initialize HIDAPI");
+    for (PendingCommand& command : pending) {
+        command.dirty = false;
     }
+    invalidateForceFeedbackCache();
 
-    device = hid_open(0x046d, 0xc24f, nullptr);
-    if (!device) {
-        throw std::runtime_error("Failed to open G29 device");
-        hid_exit();
+    for (size_t i = 0; i < static_cast<size_t>(G29Axis::Count); ++i) {
+        G29Axis axis = static_cast<G29Axis>(i);
+        setCalibration(axis, defaultCalibration(axis));
     }
 
-    cache.resize(16, 0);
-    state["steering"] = 255;
-    state["throttle"] = 255;
-    state["clutch"] = 255;
-    state["brake"] = 255;
+    state = G29State();
+    state.steering = 255;
+    state.throttle = 255;
+    state.clutch = 255;
+    state.brake = 255;
+    state.wheel = 0x8000;
+    normalizeAxes();
+    filterAxes();
+    published.store(state);
 }
 
 G29::~G29() {
-    if (device) {
-        hid_close(device);
+    startupCancelled = true;
+    if (startup.joinable()) {
+        wake();
+        startup.join();
     }
-    hid_exit();
+    joinReader();
+    stopForceFeedbackWriter();
+}
+
+void G29::connect(std::chrono::milliseconds timeout) {
+    if (!connectAsync(timeout).get()) {
+        throw std::runtime_error("Timed out waiting for the wheel to report");
+    }
+}
+
+void G29::reset(std::chrono::milliseconds timeout) {
+    if (!resetAsync(timeout).get()) {
+        throw std::runtime_error("Timed out waiting for the wheel to finish its reset");
+    }
+}
+
+std::future<bool> G29::connectAsync(std::chrono::milliseconds timeout) {
+    return startStartup(false, timeout);
 }
 
-void G29::connect() {
-    pump(10);
-    // reset();
+std::future<bool> G29::resetAsync(std::chrono::milliseconds timeout) {
+    return startStartup(true, timeout);
 }
 
-void G29::reset() {
-    uint8_t msg1[] = {0xf8, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00};
-    uint8_t msg2[] = {0xf8, 0x09, 0x05, 0x01, 0x01, 0x00, 0x00};
+std::future<bool> G29::startStartup(bool reset, std::chrono::milliseconds timeout) {
+    if (startupRunning.exchange(true)) {
+        throw std::logic_error("A connect or reset is already in progress");
+    }
+    if (startup.joinable()) {
+        startup.join();
+    }
+
+    std::shared_ptr<std::promise<bool>> promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+
+    startup = std::thread([this, promise, reset, timeout]() {
+        try {
+            if (reset) {
+                G29Message msg1 = {{0xf8, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00}};
+                G29Message msg2 = {{0xf8, 0x09, 0x05, 0x01, 0x01, 0x00, 0x00}};
+
+                writeMessage(msg1);
+                writeMessage(msg2);
+                invalidateForceFeedbackCache();
+            }
+            bool ready = waitUntilReady(reset, timeout);
+            startupRunning = false;
+            promise->set_value(ready);
+        } catch (...) {
+            startupRunning = false;
+            promise->set_exception(std::current_exception());
+        }
+    });
+
+    return result;
+}
+
+bool G29::waitUntilReady(bool expectSweep, std::chrono::milliseconds timeout) {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeout;
+    auto lastChange = start;
+    bool moved = false;
+    bool reported = false;
+
+    // The position to hold is taken from the first report; the state before
+    // it is the constructor's centred default, not where the wheel rests.
+    G29State settled = getState();
+    uint32_t reportCount = settled.reportCount;
+
+    while (!startupCancelled) {
+        // Decode the reports ourselves unless the reader thread already does.
+        if (readerRunning) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } else {
+            size_t bytes_read = pump(std::chrono::milliseconds(10));
+            if (bytes_read > 0) {
+                updateState(cache.data(), bytes_read);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        G29State current = getState();
+        if (current.reportCount != reportCount) {
+            reportCount = current.reportCount;
+            if (!reported) {
+                reported = true;
+                settled = current;
+                lastChange = now;
+            } else if (std::abs(static_cast<int>(current.wheel) - static_cast<int>(settled.wheel)) > kSettleTolerance) {
+                settled = current;
+                moved = true;
+                lastChange = now;
+            }
+        }
+
+        bool still = now - lastChange >= kSettleTime;
+        bool swept = !expectSweep || moved || now - start >= kSweepStartTimeout;
+        if (still && swept && reported) {
+            return true;
+        }
+        if (now >= deadline) {
+            return false;
+        }
+    }
+
+    return false;
+}
 
-    hid_write(device, msg1, sizeof(msg1));
-    hid_write(device, msg2, sizeof(msg2));
+namespace {
 
-    std::this_thread::sleep_for(std::chrono::seconds(10));
+/// Command byte of a slot command: the slot bit in the high nibble, the command in the low one.
+uint8_t slotCommand(unsigned slot, uint8_t command) {
+    if (slot >= G29::kForceSlotCount) {
+        throw std::out_of_range("Force slot must be below 4");
+    }
+    return static_cast<uint8_t>((0x10 << slot) | command);
 }
 
-void G29::forceFeedbackConstant(float val) {
+} // namespace
+
+G29Message G29::makeConstantForceMessage(float val, unsigned slot) {
     if (val < 0.0f || val > 1.0f) {
         throw std::out_of_range("Value must be in range of 0 to 1");
     }
 
     uint8_t val_scale = static_cast<uint8_t>(std::round(val * 255.0f));
-    uint8_t msg[] = {0x14, 0x00, val_scale, 0x00, 0x00, 0x00, 0x00};
-    hid_write(device, msg, sizeof(msg));
-
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    G29Message msg = {{slotCommand(slot, 0x04), 0x00, val_scale, 0x00, 0x00, 0x00, 0x00}};
+    return msg;
 }
 
-void G29::setAutocenter(float strength, float rate) {
+G29Message G29::makeAutocenterMessage(float strength, float rate) {
     if (strength < 0.0f || strength > 1.0f) {
         throw std::out_of_range("Strength must be in range of 0 to 1");
     }
@@ -65,146 +221,777 @@ void G29::setAutocenter(float strength, float rate) {
 
     uint8_t strength_scale = static_cast<uint8_t>(std::round(strength * 255.0f));
     uint8_t rate_scale = static_cast<uint8_t>(std::round(rate * 255.0f));
-    uint8_t msg[] = {0x05, 0x00, strength_scale, rate_scale, 0x00, 0x00, 0x00};
-    hid_write(device, msg, sizeof(msg));
+    G29Message msg = {{0x05, 0x00, strength_scale, rate_scale, 0x00, 0x00, 0x00}};
+    return msg;
+}
+
+G29Message G29::makeForceOffMessage() {
+    G29Message msg = {{0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+    return msg;
+}
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+G29Message G29::makeForceOffMessage(unsigned slot) {
+    G29Message msg = {{slotCommand(slot, 0x00), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+    return msg;
+}
+
+G29Message G29::makeRevLightsMessage(uint8_t mask) {
+    if (mask > G29RevLights::kAllLeds) {
+        throw std::out_of_range("Rev light mask must be below 0x20");
+    }
+
+    G29Message msg = {{0xf8, 0x12, mask, 0x00, 0x00, 0x00, 0x00}};
+    return msg;
+}
+
+void G29::forceFeedbackConstant(float val, unsigned slot) {
+    writeChannelMessage(static_cast<WriteChannel>(slot), makeConstantForceMessage(val, slot));
+}
+
+void G29::setAutocenter(float strength, float rate) {
+    writeChannelMessage(kAutocenterChannel, makeAutocenterMessage(strength, rate));
 }
 
 void G29::forceOff() {
-    uint8_t msg[] = {0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    hid_write(device, msg, sizeof(msg));
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        for (unsigned slot = 0; slot < kForceSlotCount; ++slot) {
+            pending[slot].dirty = false;
+        }
+    }
+
+    // A force the writer already took would undo the off message once
+    // written; the new generation makes writeQueuedCommand() drop it.
+    std::lock_guard<std::mutex> lock(writeMutex);
+    forceOffGeneration.fetch_add(1, std::memory_order_relaxed);
+    for (unsigned slot = 0; slot < kForceSlotCount; ++slot) {
+        sent[slot].valid = false;
+    }
+    writeLocked(makeForceOffMessage());
+}
+
+void G29::forceOff(unsigned slot) {
+    writeChannelMessage(static_cast<WriteChannel>(slot), makeForceOffMessage(slot));
+}
+
+void G29::invalidateForceFeedbackCache() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    for (SentCommand& command : sent) {
+        command.valid = false;
+    }
+    queuedRevLights = -1;
+}
+
+void G29::setRevLights(uint8_t mask) {
+    writeChannelMessage(kRevLightsChannel, makeRevLightsMessage(mask));
+}
+
+void G29::setRevLightsAsync(uint8_t mask) {
+    queueCommand(kRevLightsChannel, makeRevLightsMessage(mask));
+}
+
+void G29::setRevLightRange(float firstRpm, float redlineRpm) {
+    revLights = G29RevLights(firstRpm, redlineRpm);
+    queuedRevLights = -1;
+}
+
+void G29::setRpmAsync(float rpm) {
+    int mask = revLights.pattern(rpm);
+    if (queuedRevLights.exchange(mask, std::memory_order_relaxed) != mask) {
+        setRevLightsAsync(static_cast<uint8_t>(mask));
+    }
+}
+
+uint64_t G29::suppressedWriteCount() const {
+    return suppressedWrites.load(std::memory_order_relaxed);
+}
+
+void G29::writeMessage(const G29Message& message) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    writeLocked(message);
+}
+
+void G29::writeChannelMessage(WriteChannel channel, const G29Message& message) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    writeChannelLocked(channel, message);
+}
+
+void G29::writeQueuedCommand(WriteChannel channel, const PendingCommand& command) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (channel < kForceSlotCount && command.forceOffGeneration != forceOffGeneration.load(std::memory_order_relaxed)) {
+        return;
+    }
+    writeChannelLocked(channel, command.message);
+}
+
+void G29::writeChannelLocked(WriteChannel channel, const G29Message& message) {
+    SentCommand& last = sent[channel];
+    if (last.valid && last.message == message) {
+        suppressedWrites.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // After a failed write the wheel's state is unknown; write the next one.
+    last.valid = writeLocked(message) >= 0;
+    last.message = message;
+}
+
+bool G29::wasSent(WriteChannel channel, const G29Message& message) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return sent[channel].valid && sent[channel].message == message;
+}
+
+int G29::writeLocked(const G29Message& message) {
+    int result = 0;
+    if (histograms) {
+        auto start = std::chrono::steady_clock::now();
+        result = transport->write(message.data(), message.size());
+        histograms->writeLatency.record(toNanoseconds(std::chrono::steady_clock::now()) - toNanoseconds(start));
+    } else {
+        result = transport->write(message.data(), message.size());
+    }
+    if (capture) {
+        capture->append(G29RecordKind::OutputMessage, toNanoseconds(std::chrono::steady_clock::now()), message.data(), message.size());
+    }
+    return result;
+}
+
+void G29::startForceFeedbackWriter() {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (writerRunning) {
+        return;
+    }
+    writerRunning = true;
+    writer = std::thread(&G29::writerMain, this);
+}
+
+void G29::stopForceFeedbackWriter() {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        writerRunning = false;
+    }
+    writerWake.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+void G29::setForceFeedbackWriteInterval(std::chrono::microseconds interval) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    writeInterval = interval;
+}
+
+void G29::forceFeedbackConstantAsync(float val, unsigned slot) {
+    queueCommand(static_cast<WriteChannel>(slot), makeConstantForceMessage(val, slot));
+}
+
+void G29::setAutocenterAsync(float strength, float rate) {
+    queueCommand(kAutocenterChannel, makeAutocenterMessage(strength, rate));
+}
+
+void G29::forceOffAsync() {
+    for (unsigned slot = 0; slot < kForceSlotCount; ++slot) {
+        forceOffAsync(slot);
+    }
+}
+
+void G29::forceOffAsync(unsigned slot) {
+    queueCommand(static_cast<WriteChannel>(slot), makeForceOffMessage(slot));
+}
+
+uint64_t G29::coalescedCommandCount() const {
+    return coalescedCommands.load(std::memory_order_relaxed);
+}
+
+void G29::queueCommand(WriteChannel channel, const G29Message& message) {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        if (pending[channel].dirty) {
+            coalescedCommands.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending[channel].message = message;
+        pending[channel].dirty = true;
+        pending[channel].forceOffGeneration = forceOffGeneration.load(std::memory_order_relaxed);
+        if (histograms) {
+            pending[channel].queuedAt = std::chrono::steady_clock::now();
+        }
+    }
+    writerWake.notify_one();
+}
+
+void G29::writerMain() {
+    auto nextWrite = std::chrono::steady_clock::now();
+    auto nextRevLightsWrite = nextWrite;
+    PendingCommand batch[kWriteChannelCount];
+    WriteChannel channels[kWriteChannelCount];
+
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (true) {
+        size_t count = 0;
+        for (size_t channel = 0; channel < kRevLightsChannel; ++channel) {
+            if (pending[channel].dirty) {
+                channels[count] = static_cast<WriteChannel>(channel);
+                batch[count++] = pending[channel];
+                pending[channel].dirty = false;
+            }
+        }
+
+        // The rev lights go after the force commands, at most once per
+        // kRevLightsWriteInterval, so a steady force stream cannot starve them.
+        // With no force command to send, wait for their interval here, where a
+        // force command queued meanwhile still goes first.
+        if (pending[kRevLightsChannel].dirty) {
+            auto now = std::chrono::steady_clock::now();
+            if (count == 0) {
+                auto due = writerRunning ? std::max(nextWrite, nextRevLightsWrite) : nextWrite;
+                if (now < due) {
+                    writerWake.wait_until(lock, due);
+                    continue;
+                }
+            }
+            if (count == 0 || !writerRunning || now >= nextRevLightsWrite) {
+                channels[count] = kRevLightsChannel;
+                batch[count++] = pending[kRevLightsChannel];
+                pending[kRevLightsChannel].dirty = false;
+            }
+        }
+
+        if (count == 0) {
+            if (!writerRunning) {
+                break;
+            }
+            writerWake.wait(lock);
+            continue;
+        }
+        std::chrono::microseconds interval = writeInterval;
+        lock.unlock();
+        for (size_t i = 0; i < count; ++i) {
+            // Skip the pacing delay for commands the wheel already holds. The
+            // cache is read here, without writerMutex, so that queueing never
+            // waits for a write in progress.
+            if (wasSent(channels[i], batch[i].message)) {
+                suppressedWrites.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            std::this_thread::sleep_until(nextWrite);
+            // Commands queued before enableStats() carry no timestamp, and the
+            // rev lights wait on purpose, so neither counts as force feedback dwell.
+            if (histograms && channels[i] != kRevLightsChannel && batch[i].queuedAt.time_since_epoch().count() != 0) {
+                histograms->commandDwell.record(toNanoseconds(std::chrono::steady_clock::now()) - toNanoseconds(batch[i].queuedAt));
+            }
+            writeQueuedCommand(channels[i], batch[i]);
+            auto written = std::chrono::steady_clock::now();
+            nextWrite = written + interval;
+            if (channels[i] == kRevLightsChannel) {
+                nextRevLightsWrite = written + kRevLightsWriteInterval;
+            }
+        }
+        lock.lock();
+    }
 }
 
 size_t G29::pump(int timeout) {
-    size_t bytes_read = 0;
-    auto start = std::chrono::high_resolution_clock::now();
+    return pump(std::chrono::milliseconds(std::chrono::seconds(timeout)));
+}
 
-    while (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::high_resolution_clock::now() - start).count() < timeout) {
-        bytes_read = hid_read(device, cache.data(), cache.size());
-        if (bytes_read > 0) {
+size_t G29::pump(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    do {
+        if (wakeRequested.exchange(false)) {
             break;
         }
-    }
 
-    return bytes_read;
+        // Round up so that a partial millisecond still blocks instead of spinning.
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        auto remainingMs = std::max<std::chrono::microseconds::rep>(0, (remaining.count() + 999) / 1000);
+        int slice = static_cast<int>(std::min<std::chrono::microseconds::rep>(remainingMs, std::numeric_limits<int>::max()));
+        if (!transport->canWake()) {
+            slice = std::min(slice, kReadSliceMs);
+        }
+
+        int bytes_read = transport->read(cache.data(), cache.size(), slice);
+        if (bytes_read < 0) {
+            throw std::runtime_error("Failed to read from G29 device");
+        }
+        if (bytes_read > 0) {
+            previousReportTime = reportTime;
+            reportTime = std::chrono::steady_clock::now();
+            if (histograms && previousReportTime.time_since_epoch().count() != 0) {
+                histograms->interArrival.record(toNanoseconds(reportTime) - toNanoseconds(previousReportTime));
+            }
+            if (capture) {
+                capture->append(G29RecordKind::InputReport, toNanoseconds(reportTime), cache.data(), static_cast<size_t>(bytes_read));
+            }
+            return static_cast<size_t>(bytes_read);
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return 0;
+}
+
+void G29::wake() {
+    wakeRequested = true;
+    transport->wake();
+}
+
+int G29::fileDescriptor() const {
+    return transport->fileDescriptor();
 }
 
 void G29::readLoop() {
+    if (readerRunning) {
+        throw std::logic_error("readLoop() cannot be used while the reader thread is running");
+    }
+
     size_t bytes_read = pump(1);
     if (bytes_read > 0) {
-        updateState(cache);
+        updateState(cache.data(), bytes_read);
     }
 }
 
-std::unordered_map<std::string, uint8_t> G29::getState() const {
-    return state;
+namespace {
+
+void widen(G29AxisRange& range, uint8_t value) {
+    range.min = std::min(range.min, value);
+    range.max = std::max(range.max, value);
 }
 
-void G29::updateState(const std::vector<uint8_t>& byteArray) {
-    if (byteArray.size() != 16) {
+void resetRange(G29AxisRange& range, uint8_t value) {
+    range.min = value;
+    range.max = value;
+}
+
+} // namespace
+
+G29Batch G29::drain(std::chrono::milliseconds timeout) {
+    if (readerRunning) {
+        throw std::logic_error("drain() cannot be used while the reader thread is running");
+    }
+
+    G29Batch batch = {};
+    resetRange(batch.steering, state.steering);
+    resetRange(batch.throttle, state.throttle);
+    resetRange(batch.brake, state.brake);
+    resetRange(batch.clutch, state.clutch);
+
+    uint32_t previous = state.buttons;
+    size_t bytes_read = pump(timeout);
+    while (bytes_read > 0) {
+        updateState(cache.data(), bytes_read);
+        if (bytes_read == cache.size()) {
+            if (batch.reportCount == 0) {
+                resetRange(batch.steering, state.steering);
+                resetRange(batch.throttle, state.throttle);
+                resetRange(batch.brake, state.brake);
+                resetRange(batch.clutch, state.clutch);
+            } else {
+                widen(batch.steering, state.steering);
+                widen(batch.throttle, state.throttle);
+                widen(batch.brake, state.brake);
+                widen(batch.clutch, state.clutch);
+            }
+
+            batch.pressed |= state.buttons & ~previous;
+            batch.released |= previous & ~state.buttons;
+            previous = state.buttons;
+            ++batch.reportCount;
+        }
+        bytes_read = pump(std::chrono::milliseconds(0));
+    }
+
+    if (batch.reportCount > 1) {
+        coalescedReports.fetch_add(batch.reportCount - 1, std::memory_order_relaxed);
+    }
+    batch.state = state;
+    return batch;
+}
+
+void G29::startReader() {
+    if (readerRunning.exchange(true)) {
         return;
     }
+    if (reader.joinable()) {
+        reader.join();
+    }
+    readerError = nullptr;
+    reader = std::thread(&G29::readerMain, this);
+}
+
+void G29::stopReader() {
+    joinReader();
+    if (readerError) {
+        std::exception_ptr error = readerError;
+        readerError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
 
-    state["steering"] = calculateSteering(byteArray[4], byteArray[5]);
-    state["throttle"] = byteArray[6];
-    state["clutch"] = byteArray[8];
-    state["brake"] = byteArray[7];
+void G29::joinReader() {
+    readerRunning = false;
+    if (reader.joinable()) {
+        wake();
+        reader.join();
+        wakeRequested = false;
+    }
+}
 
-    updateButtonState(byteArray);
+bool G29::isReaderRunning() const {
+    return readerRunning;
 }
 
-uint8_t G29::calculateSteering(uint8_t start, uint8_t end) const {
-    if (start == 0 && end == 0) {
-        return 255;
+void G29::readerMain() {
+    try {
+        while (readerRunning) {
+            size_t bytes_read = pump(1);
+            if (bytes_read > 0) {
+                updateState(cache.data(), bytes_read);
+            }
+        }
+    } catch (const std::runtime_error&) {
+        // Kept for stopReader(); the thread that owns the wheel decides what to do.
+        readerError = std::current_exception();
+        readerRunning = false;
     }
+}
 
-    uint8_t result = 0;
-    if (start > end) {
-        result = start - end;
+G29AxisCalibration G29::defaultCalibration(G29Axis axis) {
+    G29AxisCalibration calibration = {};
+    calibration.curve = 1.0f;
+    if (axis == G29Axis::Steering) {
+        calibration.max = 0xFFFF;
     } else {
-        result = end - start;
+        calibration.max = 0xFF;
+        calibration.invert = true;
+    }
+    return calibration;
+}
+
+void G29::setCalibration(G29Axis axis, const G29AxisCalibration& calibration) {
+    if (readerRunning) {
+        throw std::logic_error("setCalibration() cannot be used while the reader thread is running");
+    }
+    if (axis >= G29Axis::Count) {
+        throw std::invalid_argument("Unknown axis");
     }
 
-    return result;
+    bool steering = axis == G29Axis::Steering;
+    size_t rawCount = steering ? 0x10000 : 0x100;
+    if (calibration.max <= calibration.min || calibration.max >= rawCount) {
+        throw std::invalid_argument("Calibration range is empty or out of the raw range");
+    }
+    if (calibration.deadzone < 0.0f || calibration.deadzone >= 1.0f) {
+        throw std::out_of_range("Deadzone must be in range of 0 to 1");
+    }
+    if (!(calibration.curve > 0.0f)) {
+        throw std::invalid_argument("Curve must be greater than 0");
+    }
+
+    std::vector<float>& table = axisTables[static_cast<size_t>(axis)];
+    table.resize(rawCount);
+
+    float span = static_cast<float>(calibration.max - calibration.min);
+    for (size_t raw = 0; raw < rawCount; ++raw) {
+        float t = (static_cast<float>(raw) - calibration.min) / span;
+        t = std::max(0.0f, std::min(1.0f, t));
+        if (calibration.invert) {
+            t = 1.0f - t;
+        }
+
+        // Steering is signed around the center, pedals start at rest.
+        float value = steering ? t * 2.0f - 1.0f : t;
+        float magnitude = std::fabs(value);
+        magnitude = magnitude < calibration.deadzone ? 0.0f : (magnitude - calibration.deadzone) / (1.0f - calibration.deadzone);
+        magnitude = std::pow(magnitude, calibration.curve);
+        table[raw] = value < 0.0f ? -magnitude : magnitude;
+    }
+
+    calibrations[static_cast<size_t>(axis)] = calibration;
 }
 
-std::string G29::updateButtonState(const std::vector<uint8_t>& byteArray) {
-    if (byteArray.size() < 16) return "";
-    //buttonState.clear();
+G29AxisCalibration G29::getCalibration(G29Axis axis) const {
+    return calibrations[static_cast<size_t>(axis)];
+}
+
+void G29::setFilter(G29Axis axis, const G29AxisFilter& filter) {
+    if (readerRunning) {
+        throw std::logic_error("setFilter() cannot be used while the reader thread is running");
+    }
+    if (axis >= G29Axis::Count) {
+        throw std::invalid_argument("Unknown axis");
+    }
+
+    filters[static_cast<size_t>(axis)].configure(filter);
+    filtering = true;
+}
+
+G29AxisFilter G29::getFilter(G29Axis axis) const {
+    return filters[static_cast<size_t>(axis)].settings();
+}
+
+void G29::startCapture(const std::string& path, size_t maxRecords) {
+    if (readerRunning || writer.joinable()) {
+        throw std::logic_error("startCapture() cannot be used while the reader or writer thread is running");
+    }
+    capture.reset();
+    capture.reset(new G29CaptureWriter(path, maxRecords));
+}
+
+void G29::stopCapture() {
+    if (readerRunning || writer.joinable()) {
+        throw std::logic_error("stopCapture() cannot be used while the reader or writer thread is running");
+    }
+    capture.reset();
+}
+
+void G29::startSharedState(const std::string& name) {
+    if (readerRunning) {
+        throw std::logic_error("startSharedState() cannot be used while the reader thread is running");
+    }
+    sharedState.reset();
+    sharedState.reset(new G29SharedStatePublisher(name));
+}
+
+void G29::stopSharedState() {
+    if (readerRunning) {
+        throw std::logic_error("stopSharedState() cannot be used while the reader thread is running");
+    }
+    sharedState.reset();
+}
+
+void G29::processReport(const uint8_t* report, size_t length) {
+    processReport(report, length, std::chrono::steady_clock::now());
+}
+
+void G29::processReport(const uint8_t* report, size_t length, std::chrono::steady_clock::time_point timestamp) {
+    reportTime = timestamp;
+    updateState(report, length);
+}
+
+void G29::enableEventQueue(size_t capacity) {
+    if (readerRunning) {
+        throw std::logic_error("enableEventQueue() cannot be used while the reader thread is running");
+    }
+    events.reset(new SpscQueue<G29Event>(capacity));
+}
+
+size_t G29::popEvents(G29Event* out, size_t maxEvents) {
+    if (!events) {
+        return 0;
+    }
+
+    size_t count = events->pop(out, maxEvents);
+    if (histograms && count > 0) {
+        uint64_t now = toNanoseconds(std::chrono::steady_clock::now());
+        for (size_t i = 0; i < count; ++i) {
+            histograms->eventDwell.record(now - out[i].timestampNs);
+        }
+    }
+    return count;
+}
+
+void G29::setDispatcher(G29Dispatcher* dispatcher) {
+    if (readerRunning) {
+        throw std::logic_error("setDispatcher() cannot be used while the reader thread is running");
+    }
+    this->dispatcher = dispatcher;
+}
+
+void G29::enableHistory(size_t capacity) {
+    if (readerRunning) {
+        throw std::logic_error("enableHistory() cannot be used while the reader thread is running");
+    }
+    history.reset(new G29History(capacity));
+}
+
+G29State G29::sampleAt(std::chrono::steady_clock::time_point time, std::chrono::microseconds horizon) const {
+    G29State sample;
+    uint64_t horizonNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(horizon).count());
+    if (!history || !history->sampleAt(toNanoseconds(time), horizonNs, sample)) {
+        return getState();
+    }
+    return sample;
+}
+
+uint64_t G29::eventOverflowCount() const {
+    return events ? events->overflowCount() : 0;
+}
+
+void G29::enableStats() {
+    if (readerRunning || writer.joinable()) {
+        throw std::logic_error("enableStats() cannot be used while the reader or writer thread is running");
+    }
+    if (!histograms) {
+        histograms.reset(new Histograms());
+    }
+}
+
+G29Stats G29::getStats() const {
+    G29Stats stats = {};
+    if (histograms) {
+        stats.interArrival = histograms->interArrival.snapshot();
+        stats.decode = histograms->decode.snapshot();
+        stats.eventDwell = histograms->eventDwell.snapshot();
+        stats.commandDwell = histograms->commandDwell.snapshot();
+        stats.writeLatency = histograms->writeLatency.snapshot();
+    }
+    stats.droppedEvents = eventOverflowCount();
+    stats.coalescedCommands = coalescedCommandCount();
+    stats.suppressedWrites = suppressedWriteCount();
+    stats.coalescedReports = coalescedReports.load(std::memory_order_relaxed);
+    stats.malformedReports = malformedReports.load(std::memory_order_relaxed);
+    return stats;
+}
+
+G29State G29::getState() const {
+    return published.load();
+}
 
-     // Correct the conditions and ensure they are distinct
-    buttonState["X"] = (byteArray[0] & 0x18) == 0x18;
-    buttonState["Square"] = (byteArray[0] & 0x28) == 0x28;
-    buttonState["Triangle"] = (byteArray[0] & 0x88) == 0x88;
-    buttonState["Circle"] = (byteArray[0] & 0x48) == 0x48;
+std::unordered_map<std::string, uint8_t> G29::getStateMap() const {
+    G29State current = getState();
+    std::unordered_map<std::string, uint8_t> map;
+    map["steering"] = current.steering;
+    map["throttle"] = current.throttle;
+    map["clutch"] = current.clutch;
+    map["brake"] = current.brake;
+    return map;
+}
 
-    buttonState["L2"] = (byteArray[1] & 0x08) == 0x08;
-    buttonState["R2"] = (byteArray[1] & 0x04) == 0x04;
-    buttonState["L3"] = (byteArray[1] & 0x80) == 0x80;
-    buttonState["R3"] = (byteArray[1] & 0x40) == 0x40;
+void G29::updateState(const std::vector<uint8_t>& byteArray) {
+    updateState(byteArray.data(), byteArray.size());
+}
 
-    buttonState["DPadUp"] = (byteArray[0] & 0x0F) == 0x00;  // Mask with 0x0F for directional checks
-    buttonState["DPadDown"] = (byteArray[0] & 0x0F) == 0x04;
-    buttonState["DPadLeft"] = (byteArray[0] & 0x0F) == 0x06;
-    buttonState["DPadRight"] = (byteArray[0] & 0x0F) == 0x02;
+void G29::updateState(const uint8_t* report, size_t length) {
+    if (length != model.reportSize) {
+        malformedReports.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
 
-    buttonState["RotaryDialPress"] = (byteArray[3] & 0x08) == 0x08;
+    std::chrono::steady_clock::time_point start;
+    if (histograms) {
+        start = std::chrono::steady_clock::now();
+    }
 
-    buttonState["PlusButton"] = (byteArray[2] & 0x80) == 0x80;
-    buttonState["MinusButton"] = (byteArray[3] & 0x01) == 0x01;
+    uint32_t previousButtons = state.buttons;
 
-    buttonState["LeftPaddle"] = (byteArray[1] & 0x02) == 0x02;
-    buttonState["RightPaddle"] = (byteArray[1] & 0x01) == 0x01;
+    model.decode(report, state);
+    normalizeAxes();
+    filterAxes();
+    ++state.reportCount;
 
-    buttonState["Share"] = (byteArray[1] & 0x10) == 0x10;
-    buttonState["Options"] = (byteArray[1] & 0x20) == 0x20;
-    buttonState["PS"] = (byteArray[3] & 0x10) == 0x10;
-    // std::cout << "Button pressed: " << getPressedButton() << std::endl;
+    buttonBits.store(state.buttons, std::memory_order_relaxed);
+    published.store(state);
 
-    if (byteArray[0] == 0x18) return "X";
-    if (byteArray[0] == 0x28) return "Square";
-    if (byteArray[0] == 0x88) return "Triangle";
-    if (byteArray[0] == 0x48) return "Circle";
+    G29Event event;
+    if (events || sharedState || history || dispatcher) {
+        event.timestampNs = toNanoseconds(reportTime);
+        event.state = state;
+        event.pressed = state.buttons & ~previousButtons;
+        event.released = previousButtons & ~state.buttons;
+        if (events) {
+            events->push(event);
+        }
+        if (sharedState) {
+            sharedState->publish(event);
+        }
+        if (history) {
+            history->record(event);
+        }
+    }
 
-    if (byteArray[1] == 0x08) return "L2";
-    if (byteArray[1] == 0x04) return "R2";
-    if (byteArray[1] == 0x80) return "L3";
-    if (byteArray[1] == 0x40) return "R3";
+    if (histograms) {
+        histograms->decode.record(toNanoseconds(std::chrono::steady_clock::now()) - toNanoseconds(start));
+    }
 
-    if (byteArray[0] == 0x00) return "DPadUp";
-    if (byteArray[0] == 0x04) return "DPadDown";
-    if (byteArray[0] == 0x06) return "DPadLeft";
-    if (byteArray[0] == 0x02) return "DPadRight";
+    // After the decode timing, so that slow handlers do not show up as decode time.
+    if (dispatcher) {
+        dispatcher->dispatch(event);
+    }
+}
 
-    if (byteArray[3] == 0x08) return "RotaryDialPress";
+void G29::normalizeAxes() {
+    state.steeringAxis = axisTables[static_cast<size_t>(G29Axis::Steering)][state.wheel];
+    state.throttleAxis = axisTables[static_cast<size_t>(G29Axis::Throttle)][state.throttle];
+    state.brakeAxis = axisTables[static_cast<size_t>(G29Axis::Brake)][state.brake];
+    state.clutchAxis = axisTables[static_cast<size_t>(G29Axis::Clutch)][state.clutch];
+}
 
-    if (byteArray[2] == 0x80) return "PlusButton";
-    if (byteArray[3] == 0x01) return "MinusButton";
+void G29::filterAxes() {
+    if (!filtering) {
+        state.steeringFiltered = state.steeringAxis;
+        state.throttleFiltered = state.throttleAxis;
+        state.brakeFiltered = state.brakeAxis;
+        state.clutchFiltered = state.clutchAxis;
+        return;
+    }
 
-    if (byteArray[1] == 0x02) return "LeftPaddle";
-    if (byteArray[1] == 0x01) return "RightPaddle";
+    // The first report has no previous timestamp; filterTime stays at the epoch
+    // until then and a zero interval restarts the filters.
+    float dt = 0.0f;
+    if (filterTime.time_since_epoch().count() != 0) {
+        auto interval = std::max<std::chrono::steady_clock::duration>(reportTime - filterTime, kMinFilterInterval);
+        dt = std::chrono::duration<float>(interval).count();
+    }
+    filterTime = reportTime;
+
+    G29AxisFilterState& steering = filters[static_cast<size_t>(G29Axis::Steering)];
+    state.steeringFiltered = steering.update(state.steeringAxis, dt);
+    state.steeringVelocity = steering.velocity();
+    state.steeringAcceleration = steering.acceleration();
+    state.throttleFiltered = filters[static_cast<size_t>(G29Axis::Throttle)].update(state.throttleAxis, dt);
+    state.brakeFiltered = filters[static_cast<size_t>(G29Axis::Brake)].update(state.brakeAxis, dt);
+    state.clutchFiltered = filters[static_cast<size_t>(G29Axis::Clutch)].update(state.clutchAxis, dt);
+}
+
+uint32_t G29::decodeButtons(const uint8_t* report) {
+    return G29ReportDecoder<G29ReportLayout>::decodeButtons(report);
+}
+
+const uint32_t* G29::buttonLookupTable(size_t byteIndex) {
+    return G29ReportDecoder<G29ReportLayout>::buttonTable(byteIndex);
+}
+
+const G29WheelModel& G29::getModel() const {
+    return model;
+}
 
-    if (byteArray[1] == 0x10) return "Share";
-    if (byteArray[1] == 0x20) return "Options";
-    if (byteArray[3] == 0x10) return "PS";
+const char* G29::buttonName(G29Button button) {
+    return kButtonNames[static_cast<size_t>(button)];
+}
 
-    return "";
+std::string G29::updateButtonState(const std::vector<uint8_t>& byteArray) {
+    return updateButtonState(byteArray.data(), byteArray.size());
 }
 
+const char* G29::updateButtonState(const uint8_t* report, size_t length) {
+    if (length < model.reportSize) return "";
 
+    state.buttons = model.decodeButtons(report);
+    buttonBits.store(state.buttons, std::memory_order_relaxed);
+    published.store(state);
+
+    G29Button pressed = model.pressedButton(report);
+    return pressed == G29Button::Count ? "" : buttonName(pressed);
+}
 
+bool G29::isButtonPressed(G29Button button) const {
+    return (buttonBits.load(std::memory_order_relaxed) & buttonMask(button)) != 0;
+}
 
 bool G29::isButtonPressed(const std::string& button) const {
-    auto it = buttonState.find(button);
-    if (it != buttonState.end()) {
-        return it->second;
+    for (size_t i = 0; i < static_cast<size_t>(G29Button::Count); ++i) {
+        if (button == kButtonNames[i]) {
+            return isButtonPressed(static_cast<G29Button>(i));
+        }
     }
     return false;
 }
 
 std::string G29::getPressedButton()  {
-    return updateButtonState(cache);
+    return getPressedButtonName();
+}
+
+const char* G29::getPressedButtonName() {
+    return updateButtonState(cache.data(), cache.size());
 }
@@ -12,7 +12,11 @@
  * Email : lahcen.boulbalah@gmail.com
  */
 
-#include <hidapi/hidapi.h>
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <unordered_map>
 #include <vector>
 #include <chrono>
@@ -20,6 +24,26 @@
 #include <stdexcept>
 #include <string>
 #include <random>
+#include <memory>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include "G29Capture.hpp"
+#include "G29Dispatcher.hpp"
+#include "G29Filter.hpp"
+#include "G29History.hpp"
+#include "G29ReportLayout.hpp"
+#include "G29RevLights.hpp"
+#include "G29SharedState.hpp"
+#include "G29State.hpp"
+#include "G29Stats.hpp"
+#include "G29Transport.hpp"
+#include "SeqLock.hpp"
+#include "SpscQueue.hpp"
+
+/// A 7-byte output report, as sent to the wheel by hid_write().
+typedef std::array<uint8_t, 7> G29Message;
 
 /**
  * @class G29
@@ -30,6 +54,13 @@
  */
 class G29 {
 public:
+    /// Number of hardware force slots; constant forces on different slots add up.
+    static const unsigned kForceSlotCount = 4;
+    /// Minimum time between two rev light writes of the writer thread.
+    static constexpr std::chrono::milliseconds kRevLightsWriteInterval{10};
+    /// Default longest extrapolation of sampleAt().
+    static constexpr std::chrono::microseconds kDefaultPredictionHorizon{8000};
+
     /**
      * @brief Constructor for the G29 class.
      * 
@@ -38,32 +69,96 @@ public:
      */
     G29();
 
+    /**
+     * @brief Constructor for the G29 class, for another supported wheel.
+     *
+     * Opens the wheel through HIDAPI by the model's USB IDs.
+     *
+     * @param model The wheel model, for example from G29WheelModel::find().
+     * @throw std::runtime_error if initialization or device opening fails.
+     */
+    explicit G29(const G29WheelModel& model);
+
+    /**
+     * @brief Constructor for the G29 class, using a given transport.
+     *
+     * @param transport The transport to exchange reports with, for example a
+     *                  G29HidrawTransport or a G29LoopbackTransport.
+     * @param model The wheel model whose reports the transport delivers.
+     * @throw std::invalid_argument if transport is null.
+     */
+    explicit G29(std::unique_ptr<G29Transport> transport, const G29WheelModel& model = G29WheelModel::g29());
+
     /**
      * @brief Destructor for the G29 class.
      * 
-     * Closes the device and finalizes the HIDAPI library.
+     * Stops the background threads and closes the transport.
      */
     ~G29();
 
     /**
      * @brief Establishes a connection with the G29 device.
      * 
-     * Performs initial setup and resets the device.
+     * Blocks until connectAsync() completes.
+     *
+     * @param timeout How long to wait at most.
+     * @throw std::runtime_error if the wheel is not ready before the timeout
+     *        or reading from the device fails.
      */
-    void connect();
+    void connect(std::chrono::milliseconds timeout = std::chrono::seconds(10));
 
     /**
      * @brief Resets the G29 device to its default state.
+     *
+     * Blocks until resetAsync() completes.
+     *
+     * @param timeout How long to wait at most.
+     * @throw std::runtime_error if the wheel is not ready before the timeout
+     *        or reading from the device fails.
+     */
+    void reset(std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+    /**
+     * @brief Waits in the background for the wheel to report and hold still.
+     *
+     * Ready once at least one report has arrived and the steering has not
+     * moved for a short settle time. Until the future is ready, pump(),
+     * readLoop() and drain() must not be called, and the reader thread must
+     * not be started or stopped; a running reader is used as is.
+     *
+     * @param timeout How long to wait at most.
+     * @return A future holding true once ready, false on timeout; it holds the
+     *         exception if reading from the device fails.
+     * @throw std::logic_error if a connect or reset is already in progress.
+     */
+    std::future<bool> connectAsync(std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+    /**
+     * @brief Sends the reset messages and waits in the background for the
+     * wheel's range-setting and calibration sweep to finish.
+     *
+     * The sweep is seen in the reports: ready once the steering has moved and
+     * then held still for a short settle time, or stayed still for a second if
+     * the wheel does not sweep. A wheel that sends no reports is never ready.
+     * Same restrictions as connectAsync() until the future is ready.
+     *
+     * @param timeout How long to wait at most, replacing the former fixed 10 s sleep.
+     * @return A future holding true once ready, false on timeout; it holds the
+     *         exception if reading from the device fails.
+     * @throw std::logic_error if a connect or reset is already in progress.
      */
-    void reset();
+    std::future<bool> resetAsync(std::chrono::milliseconds timeout = std::chrono::seconds(10));
 
     /**
      * @brief Sets a constant force feedback effect.
      * 
+     * Not written if the slot already holds the same effect.
+     *
      * @param val The strength of the effect, ranging from 0.0 to 1.0.
-     * @throw std::out_of_range if val is outside the valid range.
+     * @param slot The hardware force slot, below kForceSlotCount.
+     * @throw std::out_of_range if val or slot is outside the valid range.
      */
-    void forceFeedbackConstant(float val);
+    void forceFeedbackConstant(float val, unsigned slot = 0);
 
     /**
      * @brief Sets the auto-centering effect of the steering wheel.
@@ -75,10 +170,195 @@ public:
     void setAutocenter(float strength, float rate);
 
     /**
-     * @brief Turns off all force feedback effects.
+     * @brief Turns off the force feedback effects of every slot.
+     *
+     * Always written, as one message addressing all slots. Force commands
+     * queued for the writer thread before the call are dropped, including
+     * one it is already about to write, and what the slots are known to
+     * hold is forgotten.
      */
     void forceOff();
 
+    /**
+     * @brief Turns off the force feedback effect of a slot.
+     *
+     * @param slot The hardware force slot, below kForceSlotCount.
+     * @throw std::out_of_range if slot is outside the valid range.
+     */
+    void forceOff(unsigned slot);
+
+    /**
+     * @brief Forgets what the wheel is known to hold, so that the next effect
+     * of every slot is written even if unchanged.
+     *
+     * Call it if something else may have changed the wheel's effects, such
+     * as another process or a power cycle. reset() does it itself.
+     */
+    void invalidateForceFeedbackCache();
+
+    /**
+     * @brief Sets the rev lights, skipping the write if the wheel already shows them.
+     *
+     * @param mask The lights to turn on, one bit per light from bit 0, up to
+     *             G29RevLights::kAllLeds.
+     * @throw std::out_of_range if mask has bits above the five lights.
+     */
+    void setRevLights(uint8_t mask);
+
+    /**
+     * @brief Queues a rev light pattern for the writer thread.
+     *
+     * The writer sends the latest pattern after the pending force commands,
+     * at most once every kRevLightsWriteInterval, so the lights hold back
+     * force feedback by at most one write per interval and are not starved
+     * by a steady force stream.
+     *
+     * @param mask The lights to turn on, one bit per light from bit 0.
+     * @throw std::out_of_range if mask has bits above the five lights.
+     */
+    void setRevLightsAsync(uint8_t mask);
+
+    /**
+     * @brief Sets the RPM range shown by setRpmAsync().
+     *
+     * Must not be called while another thread calls setRpmAsync().
+     *
+     * @param firstRpm The RPM at which the first light turns on.
+     * @param redlineRpm The RPM at which all lights are on.
+     * @throw std::invalid_argument if redlineRpm is not above firstRpm.
+     */
+    void setRevLightRange(float firstRpm, float redlineRpm);
+
+    /**
+     * @brief Shows an engine RPM on the rev lights, through the writer thread.
+     *
+     * Cheap enough to call every frame: nothing is queued unless the pattern
+     * differs from the last one queued. Until setRevLightRange() is called,
+     * rpm is a fraction of the redline and each fifth lights one more light.
+     *
+     * @param rpm The engine RPM.
+     */
+    void setRpmAsync(float rpm);
+
+    /**
+     * @brief Gets the number of writes skipped because the wheel already held the effect.
+     *
+     * @return The suppressed write count.
+     */
+    uint64_t suppressedWriteCount() const;
+
+    /**
+     * @brief Starts the background thread that writes queued force feedback commands.
+     *
+     * Does nothing if the writer is already running.
+     */
+    void startForceFeedbackWriter();
+
+    /**
+     * @brief Writes any queued commands, then stops the writer thread.
+     */
+    void stopForceFeedbackWriter();
+
+    /**
+     * @brief Sets the minimum time between two writes of the writer thread.
+     *
+     * @param interval The minimum interval. Defaults to 2 ms.
+     */
+    void setForceFeedbackWriteInterval(std::chrono::microseconds interval);
+
+    /**
+     * @brief Queues a constant force feedback effect without blocking on the device.
+     *
+     * Replaces any command for the same slot not yet written, so only the
+     * latest value reaches the wheel.
+     *
+     * @param val The strength of the effect, ranging from 0.0 to 1.0.
+     * @param slot The hardware force slot, below kForceSlotCount.
+     * @throw std::out_of_range if val or slot is outside the valid range.
+     */
+    void forceFeedbackConstantAsync(float val, unsigned slot = 0);
+
+    /**
+     * @brief Queues an auto-centering effect without blocking on the device.
+     *
+     * @param strength The strength of the centering effect, ranging from 0.0 to 1.0.
+     * @param rate The rate at which the centering effect is applied, ranging from 0.0 to 1.0.
+     * @throw std::out_of_range if either parameter is outside the valid range.
+     */
+    void setAutocenterAsync(float strength, float rate);
+
+    /**
+     * @brief Queues turning off the force feedback of every slot without blocking on the device.
+     *
+     * Replaces the commands of every slot not yet written.
+     */
+    void forceOffAsync();
+
+    /**
+     * @brief Queues turning off the force feedback of a slot without blocking on the device.
+     *
+     * @param slot The hardware force slot, below kForceSlotCount.
+     * @throw std::out_of_range if slot is outside the valid range.
+     */
+    void forceOffAsync(unsigned slot);
+
+    /**
+     * @brief Gets the number of queued commands replaced before being written.
+     *
+     * @return The coalesced command count.
+     */
+    uint64_t coalescedCommandCount() const;
+
+    /**
+     * @brief Builds the message for a constant force effect.
+     *
+     * The slot is the high nibble of the command byte: 0x14 for slot 0, 0x24
+     * for slot 1, 0x44 and 0x84 for slots 2 and 3.
+     *
+     * @param val The strength of the effect, ranging from 0.0 to 1.0.
+     * @param slot The hardware force slot, below kForceSlotCount.
+     * @return The message.
+     * @throw std::out_of_range if val or slot is outside the valid range.
+     */
+    static G29Message makeConstantForceMessage(float val, unsigned slot = 0);
+
+    /**
+     * @brief Builds the message for an auto-centering effect.
+     *
+     * @param strength The strength of the centering effect, ranging from 0.0 to 1.0.
+     * @param rate The rate at which the centering effect is applied, ranging from 0.0 to 1.0.
+     * @return The message.
+     * @throw std::out_of_range if either parameter is outside the valid range.
+     */
+    static G29Message makeAutocenterMessage(float strength, float rate);
+
+    /**
+     * @brief Builds the message that turns off the force feedback of every slot.
+     *
+     * All four slot bits are set: 0xf0.
+     *
+     * @return The message.
+     */
+    static G29Message makeForceOffMessage();
+
+    /**
+     * @brief Builds the message that turns off the force feedback of a slot.
+     *
+     * @param slot The hardware force slot, below kForceSlotCount.
+     * @return The message.
+     * @throw std::out_of_range if slot is outside the valid range.
+     */
+    static G29Message makeForceOffMessage(unsigned slot);
+
+    /**
+     * @brief Builds the message that sets the rev lights.
+     *
+     * @param mask The lights to turn on, one bit per light from bit 0.
+     * @return The message.
+     * @throw std::out_of_range if mask has bits above the five lights.
+     */
+    static G29Message makeRevLightsMessage(uint8_t mask);
+
     /**
      * @brief Reads data from the G29 device.
      * 
@@ -87,17 +367,304 @@ public:
      */
     size_t pump(int timeout);
 
+    /**
+     * @brief Reads data from the G29 device, blocking in the kernel until a
+     * report arrives, the timeout expires or wake() is called.
+     *
+     * @param timeout The maximum time to wait for data.
+     * @return The number of bytes read, or 0 on timeout or wake-up.
+     * @throw std::runtime_error if reading from the device fails.
+     */
+    size_t pump(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Makes a blocked pump() return early.
+     *
+     * If no pump() is in progress, the next call returns immediately.
+     */
+    void wake();
+
+    /**
+     * @brief Gets a file descriptor that becomes readable when a report is pending.
+     *
+     * For driving drain() from an external event loop.
+     *
+     * @return The transport's descriptor, or -1 if it has none (e.g. hidapi).
+     */
+    int fileDescriptor() const;
+
     /**
      * @brief Reads input from the G29 and updates the device state.
+     *
+     * @throw std::logic_error if the background reader thread is running.
      */
     void readLoop();
 
+    /**
+     * @brief Reads every pending report and folds them into one batch.
+     *
+     * Waits up to @p timeout for the first report, then keeps reading without
+     * blocking until the device queue is empty. Use this instead of readLoop()
+     * when consuming input slower than the device sends it.
+     *
+     * @param timeout The maximum time to wait for the first report.
+     * @return The latest state, the button edges and axis ranges seen over
+     *         the batch, and the number of reports coalesced.
+     * @throw std::logic_error if the background reader thread is running.
+     */
+    G29Batch drain(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    /**
+     * @brief Decodes a report obtained elsewhere, as if pump() had just read it.
+     *
+     * For replays and callers that read the device themselves. Must not be
+     * called while the background reader thread is running.
+     *
+     * @param report The raw report.
+     * @param length The length of the report, in bytes; anything but the
+     *               model's report size is ignored and counted in
+     *               G29Stats::malformedReports.
+     */
+    void processReport(const uint8_t* report, size_t length);
+
+    /**
+     * @brief Starts a background thread that reads and decodes reports.
+     *
+     * While the reader is running, readLoop(), updateButtonState() and
+     * getPressedButton() must not be called; use getState() and
+     * isButtonPressed() instead. Does nothing if the reader is already running.
+     * An error a previous reader stopped on and stopReader() did not report
+     * is discarded.
+     */
+    void startReader();
+
+    /**
+     * @brief Stops the background reader thread and waits for it to exit.
+     *
+     * If the reader had already stopped because reading failed, the error it
+     * stopped on is rethrown here, once.
+     *
+     * @throw std::runtime_error if the reader stopped on a read error.
+     */
+    void stopReader();
+
+    /**
+     * @brief Checks if the background reader thread is running.
+     *
+     * @return true if the reader is running, false otherwise.
+     */
+    bool isReaderRunning() const;
+
+    /**
+     * @brief Sets how an axis is normalized.
+     *
+     * The calibration is precomputed into a lookup table, so decoding a
+     * report only costs one table load per axis.
+     *
+     * @param axis The axis to calibrate.
+     * @param calibration The calibration.
+     * @throw std::logic_error if the background reader thread is running.
+     * @throw std::invalid_argument if the axis is unknown, the range is empty,
+     *        a pedal range exceeds 255 or the curve is not positive.
+     * @throw std::out_of_range if the deadzone is not in [0, 1).
+     */
+    void setCalibration(G29Axis axis, const G29AxisCalibration& calibration);
+
+    /**
+     * @brief Gets the calibration of an axis.
+     *
+     * @param axis The axis.
+     * @return The calibration.
+     */
+    G29AxisCalibration getCalibration(G29Axis axis) const;
+
+    /**
+     * @brief Gets the calibration used until setCalibration() is called.
+     *
+     * Full raw range and linear response; pedals are inverted so that a
+     * released pedal reads 0.
+     *
+     * @param axis The axis.
+     * @return The default calibration.
+     */
+    static G29AxisCalibration defaultCalibration(G29Axis axis);
+
+    /**
+     * @brief Sets how a calibrated axis is smoothed, and turns on the filter stage.
+     *
+     * The filter stage runs once per report, after calibration. It fills the
+     * filtered axes of G29State and the steering velocity and acceleration,
+     * differentiated from the report timestamps. Until it is turned on, the
+     * filtered axes equal the calibrated ones and the derivatives are 0.
+     *
+     * @param axis The axis to filter.
+     * @param filter The filter settings.
+     * @throw std::logic_error if the background reader thread is running.
+     * @throw std::invalid_argument if a cutoff is not positive or beta is negative.
+     * @throw std::out_of_range if the deadband is not in [0, 1).
+     */
+    void setFilter(G29Axis axis, const G29AxisFilter& filter);
+
+    /**
+     * @brief Gets the filter settings of an axis.
+     *
+     * @param axis The axis.
+     * @return The settings, G29AxisFilterState::defaultFilter() unless set.
+     */
+    G29AxisFilter getFilter(G29Axis axis) const;
+
+    /**
+     * @brief Starts recording every report read and every message written.
+     *
+     * Records go to a preallocated, memory-mapped file (see G29CaptureWriter)
+     * and can be fed back with G29Replay. Replaces any capture in progress.
+     *
+     * @param path The capture file to create.
+     * @param maxRecords The number of records to preallocate; later ones are dropped.
+     * @throw std::logic_error if the reader or force feedback writer thread is running.
+     * @throw std::runtime_error if the file cannot be created.
+     */
+    void startCapture(const std::string& path, size_t maxRecords);
+
+    /**
+     * @brief Stops recording and closes the capture file.
+     *
+     * @throw std::logic_error if the reader or force feedback writer thread is running.
+     */
+    void stopCapture();
+
+    /**
+     * @brief Starts publishing every decoded report to a shared-memory segment.
+     *
+     * Other processes read it with G29SharedStateReader. Replaces any
+     * segment already published.
+     *
+     * @param name The segment name, starting with a slash, for example "/g29".
+     * @throw std::logic_error if the background reader thread is running.
+     * @throw std::runtime_error if the segment cannot be created.
+     */
+    void startSharedState(const std::string& name);
+
+    /**
+     * @brief Stops publishing and removes the shared-memory segment.
+     *
+     * @throw std::logic_error if the background reader thread is running.
+     */
+    void stopSharedState();
+
+    /**
+     * @brief Enables the queue of timestamped input events.
+     *
+     * Once enabled, every decoded report is queued with its read time and the
+     * button edges it caused, so that no tap is lost between polls. When the
+     * queue is full new events are dropped and counted by eventOverflowCount().
+     *
+     * @param capacity The number of events the queue holds. Must be a power of two.
+     * @throw std::logic_error if the background reader thread is running.
+     * @throw std::invalid_argument if capacity is not a power of two.
+     */
+    void enableEventQueue(size_t capacity = 1024);
+
+    /**
+     * @brief Removes queued events, oldest first, without blocking or allocating.
+     *
+     * Must only be called from one consumer thread at a time.
+     *
+     * @param events Where to copy the events.
+     * @param maxEvents The maximum number of events to remove.
+     * @return The number of events removed, 0 if the queue is not enabled.
+     */
+    size_t popEvents(G29Event* events, size_t maxEvents);
+
+    /**
+     * @brief Calls a dispatcher's handlers for every decoded report.
+     *
+     * The handlers run on the decoding thread (the reader thread, or the
+     * caller of readLoop() and drain()), after the report is published.
+     *
+     * @param dispatcher The dispatcher, or nullptr to stop dispatching. It
+     *                   must outlive the wheel or be removed first.
+     * @throw std::logic_error if the background reader thread is running.
+     */
+    void setDispatcher(G29Dispatcher* dispatcher);
+
+    /**
+     * @brief Enables the history of recent reports used by sampleAt().
+     *
+     * @param capacity The number of reports kept, at least 2.
+     * @throw std::logic_error if the background reader thread is running.
+     * @throw std::invalid_argument if capacity is less than 2.
+     */
+    void enableHistory(size_t capacity = 64);
+
+    /**
+     * @brief Estimates the state at a given time, such as the start of a frame.
+     *
+     * Interpolates between the reports around the time, or extrapolates past
+     * the newest one, holding at horizon (see G29History::sampleAt()). Can be
+     * called from any thread without blocking the decoder or allocating.
+     *
+     * @param time The time to sample at.
+     * @param horizon The longest extrapolation past the newest report.
+     * @return The estimated state, or getState() if the history is not
+     *         enabled or empty.
+     */
+    G29State sampleAt(std::chrono::steady_clock::time_point time,
+                      std::chrono::microseconds horizon = kDefaultPredictionHorizon) const;
+
+    /**
+     * @brief Gets the number of events dropped because the queue was full.
+     *
+     * @return The overflow count, 0 if the queue is not enabled.
+     */
+    uint64_t eventOverflowCount() const;
+
+    /**
+     * @brief Enables the latency histograms reported by getStats().
+     *
+     * Until then the input and force feedback paths take no timestamps beyond
+     * the read time, and getStats() only reports the counters.
+     *
+     * @throw std::logic_error if the reader or force feedback writer thread is running.
+     */
+    void enableStats();
+
+    /**
+     * @brief Gets the latency histograms and counters.
+     *
+     * Safe to call from any thread while the wheel is in use; allocates.
+     *
+     * @return The statistics since enableStats(), with empty histograms if
+     *         they are not enabled.
+     */
+    G29Stats getStats() const;
+
     /**
      * @brief Gets the current state of the G29 device.
-     * 
+     *
+     * Does not allocate and is safe to call from any thread at any rate,
+     * including while the reader thread is decoding a report.
+     *
+     * @return A copy of the last published state.
+     */
+    G29State getState() const;
+
+    /**
+     * @brief Gets the current state of the G29 device as a string-keyed map.
+     *
+     * Compatibility wrapper around getState(); allocates on every call.
+     *
      * @return An unordered map containing the current state of various inputs.
      */
-    std::unordered_map<std::string, uint8_t> getState() const;
+    std::unordered_map<std::string, uint8_t> getStateMap() const;
+
+    /**
+     * @brief Checks if a specific button is currently pressed.
+     *
+     * @param button The button to check.
+     * @return true if the button is pressed, false otherwise.
+     */
+    bool isButtonPressed(G29Button button) const;
 
     /**
      * @brief Checks if a specific button is currently pressed.
@@ -114,6 +681,14 @@ public:
      */
     std::string getPressedButton();
 
+    /**
+     * @brief Gets the name of a currently pressed button, without allocating.
+     *
+     * @return The name of a pressed button, as returned by buttonName(), or
+     *         an empty string if no button is pressed.
+     */
+    const char* getPressedButtonName();
+
     /**
      * @brief Updates the state of all buttons based on raw input data.
      * 
@@ -122,13 +697,151 @@ public:
      */
     std::string updateButtonState(const std::vector<uint8_t>& byteArray);
 
+    /**
+     * @brief Updates the state of all buttons based on a raw report, without allocating.
+     *
+     * The report is decoded with the layout of the wheel model.
+     *
+     * @param report The raw report.
+     * @param length The length of the report, in bytes.
+     * @return The name of the first pressed button found, or an empty string
+     *         if no button is pressed or the report is too short.
+     */
+    const char* updateButtonState(const uint8_t* report, size_t length);
+
+    /**
+     * @brief Decodes the button bytes of a G29 report into a bitmask.
+     *
+     * Always uses G29ReportLayout, whatever the model of an instance; reports
+     * of other layouts go through G29ReportDecoder.
+     *
+     * @param report The raw report, at least 4 bytes long.
+     * @return The pressed buttons, one bit per G29Button.
+     */
+    static uint32_t decodeButtons(const uint8_t* report);
+
+    /**
+     * @brief Gets the lookup table decodeButtons() uses for one G29 report byte.
+     *
+     * decodeButtons() is the OR of the four tables indexed by report bytes 0
+     * to 3. Like decodeButtons(), always G29ReportLayout.
+     *
+     * @param byteIndex The report byte, from 0 to 3.
+     * @return 256 button bitmasks, indexed by the byte value.
+     */
+    static const uint32_t* buttonLookupTable(size_t byteIndex);
+
+    /**
+     * @brief Gets the name of a button, as accepted by isButtonPressed().
+     *
+     * @param button The button.
+     * @return The name of the button.
+     */
+    static const char* buttonName(G29Button button);
 
+    /**
+     * @brief Gets the wheel model whose reports are decoded.
+     *
+     * @return The model given to the constructor.
+     */
+    const G29WheelModel& getModel() const;
 
 private:
-    hid_device* device;  ///< Pointer to the HID device.
+    friend class G29Replay;
+
+    std::unique_ptr<G29Transport> transport;  ///< How reports reach the device.
+    G29WheelModel model;  ///< Report size and decoder of the wheel.
     std::vector<uint8_t> cache;  ///< Buffer for storing raw input data.
-    std::unordered_map<std::string, uint8_t> state;  ///< Current state of analog inputs.
-    std::unordered_map<std::string, bool> buttonState;  ///< Current state of buttons.
+    G29State state;  ///< Decoder-side state, only touched by the decoding thread.
+    SeqLock<G29State> published;  ///< Latest decoded state, readable from any thread.
+    std::atomic<uint32_t> buttonBits;  ///< Latest button bitmask, for single-load button queries.
+    std::chrono::steady_clock::time_point reportTime;  ///< When pump() last read a report.
+    std::chrono::steady_clock::time_point previousReportTime;  ///< When pump() read the report before the last.
+    std::unique_ptr<SpscQueue<G29Event>> events;  ///< Decoded reports, if the event queue is enabled.
+    std::unique_ptr<G29CaptureWriter> capture;  ///< Recording of reads and writes, if enabled.
+    std::unique_ptr<G29SharedStatePublisher> sharedState;  ///< Shared-memory publisher, if enabled.
+    std::unique_ptr<G29History> history;  ///< Recent reports for sampleAt(), if enabled.
+    G29Dispatcher* dispatcher;  ///< Handlers called for every report, if set.
+    G29AxisCalibration calibrations[static_cast<size_t>(G29Axis::Count)];  ///< Calibration per axis.
+    std::vector<float> axisTables[static_cast<size_t>(G29Axis::Count)];  ///< Raw value to normalized value, per axis.
+    G29AxisFilterState filters[static_cast<size_t>(G29Axis::Count)];  ///< Filter stage state, per axis.
+    bool filtering;  ///< Whether the filter stage runs; set by setFilter().
+    std::chrono::steady_clock::time_point filterTime;  ///< Timestamp of the last report the filter stage saw.
+
+    /// Commands that supersede each other share a channel: one per hardware
+    /// force slot, numbered like the slots, autocenter, and the rev lights,
+    /// which the writer thread serves after the force commands.
+    enum WriteChannel {
+        kAutocenterChannel = kForceSlotCount,
+        kRevLightsChannel,
+        kWriteChannelCount
+    };
+
+    /// Last message written on a channel, to skip writing it again.
+    struct SentCommand {
+        G29Message message;
+        bool valid;
+    };
+
+    /// Latest command queued on a channel.
+    struct PendingCommand {
+        G29Message message;
+        bool dirty;
+        std::chrono::steady_clock::time_point queuedAt;
+        uint64_t forceOffGeneration;  ///< forceOffGeneration when queued.
+    };
+
+    /// Histograms recorded once enableStats() is called.
+    struct Histograms {
+        G29Histogram interArrival;
+        G29Histogram decode;
+        G29Histogram eventDwell;
+        G29Histogram commandDwell;
+        G29Histogram writeLatency;
+    };
+
+    std::mutex writeMutex;  ///< Serializes hid_write() calls and guards the sent commands.
+    SentCommand sent[kWriteChannelCount];  ///< What the wheel holds, per channel.
+    std::atomic<uint64_t> forceOffGeneration;  ///< Number of forceOff() calls; changed under writeMutex.
+    std::atomic<uint64_t> suppressedWrites;  ///< Writes skipped because the wheel held the message.
+    std::mutex writerMutex;  ///< Guards the pending commands and writer flags.
+    std::condition_variable writerWake;  ///< Signalled when a command is queued or the writer stops.
+    std::thread writer;  ///< Background force feedback writer thread.
+    bool writerRunning;  ///< Whether the writer thread should keep running.
+    std::chrono::microseconds writeInterval;  ///< Minimum time between two writer writes.
+    PendingCommand pending[kWriteChannelCount];  ///< Latest command per channel.
+    std::atomic<uint64_t> coalescedCommands;  ///< Commands replaced before being written.
+    G29RevLights revLights;  ///< RPM thresholds of setRpmAsync().
+    std::atomic<int> queuedRevLights;  ///< Last pattern setRpmAsync() queued, -1 if none.
+    std::atomic<uint64_t> coalescedReports;  ///< Reports folded into a later one by drain().
+    std::atomic<uint64_t> malformedReports;  ///< Reports ignored because of their length.
+    std::unique_ptr<Histograms> histograms;  ///< Latency histograms, if enabled.
+    std::thread reader;  ///< Background reader thread.
+    std::exception_ptr readerError;  ///< What stopped the reader thread, until stopReader() rethrows it.
+    std::atomic<bool> readerRunning;  ///< Whether the reader thread should keep running.
+    std::atomic<bool> wakeRequested;  ///< Set by wake() to interrupt pump().
+    std::thread startup;  ///< Background connectAsync() or resetAsync() thread.
+    std::atomic<bool> startupRunning;  ///< Whether a connect or reset is in progress.
+    std::atomic<bool> startupCancelled;  ///< Set by the destructor to end a connect or reset early.
+
+    /// Longest single blocking read when the transport cannot be woken,
+    /// bounding how long wake() takes to be seen.
+    static const int kReadSliceMs = 50;
+
+    /// How long the steering must hold still for the wheel to be ready.
+    static constexpr std::chrono::milliseconds kSettleTime{250};
+    /// How long resetAsync() waits for the calibration sweep to start.
+    static constexpr std::chrono::milliseconds kSweepStartTimeout{1000};
+    /// Steering change, in 16-bit wheel units, below which the wheel counts as still.
+    static const int kSettleTolerance = 64;
+    /// Shortest report interval the filter stage differentiates over; reports
+    /// queued by the kernel are read back to back, faster than the wheel sends them.
+    static constexpr std::chrono::microseconds kMinFilterInterval{1000};
+
+    /**
+     * @brief Stops the background reader thread without reporting its error.
+     */
+    void joinReader();
 
     /**
      * @brief Updates the device state based on raw input data.
@@ -138,13 +851,121 @@ private:
     void updateState(const std::vector<uint8_t>& byteArray);
 
     /**
-     * @brief Calculates the steering wheel position.
-     * 
-     * @param start The starting value of the steering position.
-     * @param end The ending value of the steering position.
-     * @return The calculated steering wheel position.
+     * @brief Updates the device state based on a raw report.
+     *
+     * @param report The raw report.
+     * @param length The length of the report, in bytes.
+     */
+    void updateState(const uint8_t* report, size_t length);
+
+    /**
+     * @brief Decodes a report as if pump() had read it at @p timestamp.
+     *
+     * Lets G29Replay keep the recorded timing, which the filter stage, the
+     * history and the event timestamps depend on.
+     *
+     * @param report The raw report.
+     * @param length The length of the report, in bytes.
+     * @param timestamp When the report was read.
+     */
+    void processReport(const uint8_t* report, size_t length, std::chrono::steady_clock::time_point timestamp);
+
+    /**
+     * @brief Fills the normalized axes of the state from its raw values,
+     * using the calibration lookup tables.
+     */
+    void normalizeAxes();
+
+    /**
+     * @brief Fills the filtered axes and steering derivatives of the state,
+     * if the filter stage is on.
+     */
+    void filterAxes();
+
+    /**
+     * @brief Body of the background reader thread.
      */
-    uint8_t calculateSteering(uint8_t start, uint8_t end) const;
+    void readerMain();
 
-    
+    /**
+     * @brief Runs a connect or reset on the startup thread.
+     *
+     * @param reset Whether to send the reset messages and wait for a sweep.
+     * @param timeout How long to wait at most.
+     * @return The future of the result.
+     * @throw std::logic_error if a connect or reset is already in progress.
+     */
+    std::future<bool> startStartup(bool reset, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Watches the reports until the steering settles.
+     *
+     * @param expectSweep Whether to wait for the steering to move first.
+     * @param timeout How long to wait at most.
+     * @return true once settled, false on timeout or cancellation.
+     * @throw std::runtime_error if reading from the device fails.
+     */
+    bool waitUntilReady(bool expectSweep, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Writes a message to the device, serialized with other writes.
+     *
+     * @param message The message to write.
+     */
+    void writeMessage(const G29Message& message);
+
+    /**
+     * @brief Writes a message on a channel, unless it was the last one written there.
+     *
+     * @param channel The channel.
+     * @param message The message to write.
+     */
+    void writeChannelMessage(WriteChannel channel, const G29Message& message);
+
+    /**
+     * @brief Writes a command taken from the writer queue, unless the wheel
+     *        holds it or all slots were turned off since it was queued.
+     *
+     * @param channel The channel.
+     * @param command The queued command.
+     */
+    void writeQueuedCommand(WriteChannel channel, const PendingCommand& command);
+
+    /**
+     * @brief Body of writeChannelMessage(), with writeMutex held.
+     *
+     * @param channel The channel.
+     * @param message The message to write.
+     */
+    void writeChannelLocked(WriteChannel channel, const G29Message& message);
+
+    /**
+     * @brief Checks if a message was the last one written on a channel.
+     *
+     * @param channel The channel.
+     * @param message The message.
+     * @return true if the wheel already holds the message, false otherwise.
+     */
+    bool wasSent(WriteChannel channel, const G29Message& message);
+
+    /**
+     * @brief Writes a message to the device; writeMutex must be held.
+     *
+     * @param message The message to write.
+     * @return The transport's result, -1 on error.
+     */
+    int writeLocked(const G29Message& message);
+
+    /**
+     * @brief Queues a message on a channel for the writer thread.
+     *
+     * @param channel The channel, replacing its pending command if any.
+     * @param message The message to queue.
+     */
+    void queueCommand(WriteChannel channel, const G29Message& message);
+
+    /**
+     * @brief Body of the background force feedback writer thread.
+     */
+    void writerMain();
 };
@@ -0,0 +1,249 @@
+#include "G29BatchDecoder.hpp"
+#include "G29ReportLayout.hpp"
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__)
+#define G29_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+const size_t G29BatchDecoder::kReportSize;
+
+namespace {
+
+typedef G29ReportDecoder<G29ReportLayout> Decoder;
+
+// The kernels transpose 16-byte reports and look up bytes 0 to 3 as buttons.
+static_assert(G29BatchDecoder::kReportSize == G29ReportLayout::kReportSize, "Batch reports are G29 reports");
+static_assert(G29ReportLayout::kReportSize == 16, "The kernels transpose 16-byte reports");
+static_assert(G29ReportLayout::kFirstButtonByte == 0 && G29ReportLayout::kButtonByteCount == 4,
+              "The kernels look up four button bytes starting at byte 0");
+
+const size_t kWheelLow = G29ReportLayout::kWheelLow;
+const size_t kWheelHigh = G29ReportLayout::kWheelHigh;
+const size_t kThrottle = G29ReportLayout::kThrottle;
+const size_t kBrake = G29ReportLayout::kBrake;
+const size_t kClutch = G29ReportLayout::kClutch;
+
+void decodeScalar(const uint8_t* reports, size_t count, const G29ReportColumns& out) {
+    const uint32_t* table0 = Decoder::buttonTable(0);
+    const uint32_t* table1 = Decoder::buttonTable(1);
+    const uint32_t* table2 = Decoder::buttonTable(2);
+    const uint32_t* table3 = Decoder::buttonTable(3);
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* report = reports + i * G29BatchDecoder::kReportSize;
+        out.wheel[i] = static_cast<uint16_t>(report[kWheelLow] | (report[kWheelHigh] << 8));
+        out.throttle[i] = report[kThrottle];
+        out.brake[i] = report[kBrake];
+        out.clutch[i] = report[kClutch];
+        out.buttons[i] = table0[report[0]] | table1[report[1]] | table2[report[2]] | table3[report[3]];
+    }
+}
+
+#ifdef G29_BATCH_X86
+
+/// Transposes 16 reports so that row k holds byte k of every report.
+void transpose16(const __m128i in[16], __m128i rows[16]) {
+    __m128i s1[16];
+    __m128i s2[16];
+    __m128i s3[16];
+
+    for (int i = 0; i < 8; ++i) {
+        s1[i] = _mm_unpacklo_epi8(in[2 * i], in[2 * i + 1]);
+        s1[i + 8] = _mm_unpackhi_epi8(in[2 * i], in[2 * i + 1]);
+    }
+    for (int h = 0; h < 16; h += 8) {
+        for (int j = 0; j < 4; ++j) {
+            s2[h + j] = _mm_unpacklo_epi16(s1[h + 2 * j], s1[h + 2 * j + 1]);
+            s2[h + j + 4] = _mm_unpackhi_epi16(s1[h + 2 * j], s1[h + 2 * j + 1]);
+        }
+    }
+    for (int g = 0; g < 16; g += 4) {
+        for (int k = 0; k < 2; ++k) {
+            s3[g + k] = _mm_unpacklo_epi32(s2[g + 2 * k], s2[g + 2 * k + 1]);
+            s3[g + k + 2] = _mm_unpackhi_epi32(s2[g + 2 * k], s2[g + 2 * k + 1]);
+        }
+    }
+    for (int g = 0; g < 16; g += 4) {
+        rows[g] = _mm_unpacklo_epi64(s3[g], s3[g + 1]);
+        rows[g + 1] = _mm_unpackhi_epi64(s3[g], s3[g + 1]);
+        rows[g + 2] = _mm_unpacklo_epi64(s3[g + 2], s3[g + 3]);
+        rows[g + 3] = _mm_unpackhi_epi64(s3[g + 2], s3[g + 3]);
+    }
+}
+
+void decodeSSE2(const uint8_t* reports, size_t count, const G29ReportColumns& out) {
+    const uint32_t* table0 = Decoder::buttonTable(0);
+    const uint32_t* table1 = Decoder::buttonTable(1);
+    const uint32_t* table2 = Decoder::buttonTable(2);
+    const uint32_t* table3 = Decoder::buttonTable(3);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8_t* block = reports + i * G29BatchDecoder::kReportSize;
+        __m128i in[16];
+        __m128i rows[16];
+        for (int r = 0; r < 16; ++r) {
+            in[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + r * G29BatchDecoder::kReportSize));
+        }
+        transpose16(in, rows);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.wheel + i), _mm_unpacklo_epi8(rows[kWheelLow], rows[kWheelHigh]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.wheel + i + 8), _mm_unpackhi_epi8(rows[kWheelLow], rows[kWheelHigh]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.throttle + i), rows[kThrottle]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.brake + i), rows[kBrake]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.clutch + i), rows[kClutch]);
+
+        alignas(16) uint8_t bytes[4][16];
+        for (int b = 0; b < 4; ++b) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(bytes[b]), rows[b]);
+        }
+        for (int r = 0; r < 16; ++r) {
+            out.buttons[i + r] = table0[bytes[0][r]] | table1[bytes[1][r]] | table2[bytes[2][r]] | table3[bytes[3][r]];
+        }
+    }
+
+    G29ReportColumns tail = {out.wheel + i, out.throttle + i, out.brake + i, out.clutch + i, out.buttons + i};
+    decodeScalar(reports + i * G29BatchDecoder::kReportSize, count - i, tail);
+}
+
+/// Same as transpose16(), on two independent blocks of 16 reports, one per 128-bit lane.
+__attribute__((target("avx2")))
+void transpose32(const __m256i in[16], __m256i rows[16]) {
+    __m256i s1[16];
+    __m256i s2[16];
+    __m256i s3[16];
+
+    for (int i = 0; i < 8; ++i) {
+        s1[i] = _mm256_unpacklo_epi8(in[2 * i], in[2 * i + 1]);
+        s1[i + 8] = _mm256_unpackhi_epi8(in[2 * i], in[2 * i + 1]);
+    }
+    for (int h = 0; h < 16; h += 8) {
+        for (int j = 0; j < 4; ++j) {
+            s2[h + j] = _mm256_unpacklo_epi16(s1[h + 2 * j], s1[h + 2 * j + 1]);
+            s2[h + j + 4] = _mm256_unpackhi_epi16(s1[h + 2 * j], s1[h + 2 * j + 1]);
+        }
+    }
+    for (int g = 0; g < 16; g += 4) {
+        for (int k = 0; k < 2; ++k) {
+            s3[g + k] = _mm256_unpacklo_epi32(s2[g + 2 * k], s2[g + 2 * k + 1]);
+            s3[g + k + 2] = _mm256_unpackhi_epi32(s2[g + 2 * k], s2[g + 2 * k + 1]);
+        }
+    }
+    for (int g = 0; g < 16; g += 4) {
+        rows[g] = _mm256_unpacklo_epi64(s3[g], s3[g + 1]);
+        rows[g + 1] = _mm256_unpackhi_epi64(s3[g], s3[g + 1]);
+        rows[g + 2] = _mm256_unpacklo_epi64(s3[g + 2], s3[g + 3]);
+        rows[g + 3] = _mm256_unpackhi_epi64(s3[g + 2], s3[g + 3]);
+    }
+}
+
+/// Looks up the buttons of 8 reports, given their bytes 0 to 3 in the low 8 bytes of each vector.
+__attribute__((target("avx2")))
+__m256i gatherButtons(__m128i byte0, __m128i byte1, __m128i byte2, __m128i byte3) {
+    const int* table0 = reinterpret_cast<const int*>(Decoder::buttonTable(0));
+    const int* table1 = reinterpret_cast<const int*>(Decoder::buttonTable(1));
+    const int* table2 = reinterpret_cast<const int*>(Decoder::buttonTable(2));
+    const int* table3 = reinterpret_cast<const int*>(Decoder::buttonTable(3));
+
+    __m256i bits = _mm256_i32gather_epi32(table0, _mm256_cvtepu8_epi32(byte0), 4);
+    bits = _mm256_or_si256(bits, _mm256_i32gather_epi32(table1, _mm256_cvtepu8_epi32(byte1), 4));
+    bits = _mm256_or_si256(bits, _mm256_i32gather_epi32(table2, _mm256_cvtepu8_epi32(byte2), 4));
+    bits = _mm256_or_si256(bits, _mm256_i32gather_epi32(table3, _mm256_cvtepu8_epi32(byte3), 4));
+    return bits;
+}
+
+__attribute__((target("avx2")))
+void decodeAVX2(const uint8_t* reports, size_t count, const G29ReportColumns& out) {
+    const size_t stride = G29BatchDecoder::kReportSize;
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const uint8_t* block = reports + i * stride;
+        __m256i in[16];
+        __m256i rows[16];
+        for (int r = 0; r < 16; ++r) {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + r * stride));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + (r + 16) * stride));
+            in[r] = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        }
+        transpose32(in, rows);
+
+        // Low lanes hold reports i..i+15, high lanes reports i+16..i+31.
+        __m256i wheelLow = _mm256_unpacklo_epi8(rows[kWheelLow], rows[kWheelHigh]);
+        __m256i wheelHigh = _mm256_unpackhi_epi8(rows[kWheelLow], rows[kWheelHigh]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.wheel + i), _mm256_permute2x128_si256(wheelLow, wheelHigh, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.wheel + i + 16), _mm256_permute2x128_si256(wheelLow, wheelHigh, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.throttle + i), rows[kThrottle]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.brake + i), rows[kBrake]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.clutch + i), rows[kClutch]);
+
+        for (int lane = 0; lane < 2; ++lane) {
+            __m128i b0 = lane ? _mm256_extracti128_si256(rows[0], 1) : _mm256_castsi256_si128(rows[0]);
+            __m128i b1 = lane ? _mm256_extracti128_si256(rows[1], 1) : _mm256_castsi256_si128(rows[1]);
+            __m128i b2 = lane ? _mm256_extracti128_si256(rows[2], 1) : _mm256_castsi256_si128(rows[2]);
+            __m128i b3 = lane ? _mm256_extracti128_si256(rows[3], 1) : _mm256_castsi256_si128(rows[3]);
+            uint32_t* buttons = out.buttons + i + lane * 16;
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(buttons), gatherButtons(b0, b1, b2, b3));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(buttons + 8),
+                                gatherButtons(_mm_srli_si128(b0, 8), _mm_srli_si128(b1, 8), _mm_srli_si128(b2, 8), _mm_srli_si128(b3, 8)));
+        }
+    }
+
+    G29ReportColumns tail = {out.wheel + i, out.throttle + i, out.brake + i, out.clutch + i, out.buttons + i};
+    decodeSSE2(reports + i * stride, count - i, tail);
+}
+
+#endif
+
+} // namespace
+
+bool G29BatchDecoder::isSupported(G29DecodeKernel kernel) {
+    switch (kernel) {
+    case G29DecodeKernel::Auto:
+    case G29DecodeKernel::Scalar:
+        return true;
+#ifdef G29_BATCH_X86
+    case G29DecodeKernel::SSE2:
+        return true;
+    case G29DecodeKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+G29DecodeKernel G29BatchDecoder::bestKernel() {
+    if (isSupported(G29DecodeKernel::AVX2)) {
+        return G29DecodeKernel::AVX2;
+    }
+    if (isSupported(G29DecodeKernel::SSE2)) {
+        return G29DecodeKernel::SSE2;
+    }
+    return G29DecodeKernel::Scalar;
+}
+
+void G29BatchDecoder::decode(const uint8_t* reports, size_t count, const G29ReportColumns& out, G29DecodeKernel kernel) {
+    if (kernel == G29DecodeKernel::Auto) {
+        kernel = bestKernel();
+    }
+    if (!isSupported(kernel)) {
+        throw std::invalid_argument("Decode kernel is not supported on this CPU");
+    }
+
+    switch (kernel) {
+#ifdef G29_BATCH_X86
+    case G29DecodeKernel::AVX2:
+        decodeAVX2(reports, count, out);
+        break;
+    case G29DecodeKernel::SSE2:
+        decodeSSE2(reports, count, out);
+        break;
+#endif
+    default:
+        decodeScalar(reports, count, out);
+        break;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum G29DecodeKernel
+ * @brief Implementations of the batch decoder.
+ */
+enum class G29DecodeKernel {
+    Auto,  ///< The fastest kernel the CPU supports.
+    Scalar,  ///< Portable one-report-at-a-time loop.
+    SSE2,  ///< 16 reports per iteration with a 16x16 byte transpose.
+    AVX2  ///< 32 reports per iteration, with gathered button lookups.
+};
+
+/**
+ * @struct G29ReportColumns
+ * @brief Structure-of-arrays output of the batch decoder.
+ *
+ * Each array must hold at least as many elements as there are reports.
+ */
+struct G29ReportColumns {
+    uint16_t* wheel;  ///< 16-bit wheel position, as in G29State::wheel.
+    uint8_t* throttle;  ///< Raw throttle byte.
+    uint8_t* brake;  ///< Raw brake byte.
+    uint8_t* clutch;  ///< Raw clutch byte.
+    uint32_t* buttons;  ///< Button bitmask, as in G29State::buttons.
+};
+
+/**
+ * @class G29BatchDecoder
+ * @brief Decodes recorded streams of raw G29 reports in bulk.
+ *
+ * Meant for offline processing, where millions of reports are decoded at
+ * once; live input goes through G29 itself. Only G29ReportLayout reports are
+ * supported, since the kernels are written for its 16-byte report and four
+ * button bytes.
+ */
+class G29BatchDecoder {
+public:
+    /// Size of one raw report, in bytes; G29ReportLayout::kReportSize.
+    static const size_t kReportSize = 16;
+
+    /**
+     * @brief Decodes contiguous reports into columns.
+     *
+     * @param reports The reports, kReportSize bytes each, back to back.
+     * @param count The number of reports.
+     * @param out Where to write the decoded values.
+     * @param kernel The implementation to use.
+     * @throw std::invalid_argument if the kernel is not supported by this CPU.
+     */
+    static void decode(const uint8_t* reports, size_t count, const G29ReportColumns& out,
+                       G29DecodeKernel kernel = G29DecodeKernel::Auto);
+
+    /**
+     * @brief Checks if a kernel can run on this CPU.
+     *
+     * @param kernel The kernel.
+     * @return true if the kernel is supported, false otherwise.
+     */
+    static bool isSupported(G29DecodeKernel kernel);
+
+    /**
+     * @brief Gets the kernel used for G29DecodeKernel::Auto.
+     *
+     * @return The fastest supported kernel.
+     */
+    static G29DecodeKernel bestKernel();
+};
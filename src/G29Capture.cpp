@@ -0,0 +1,165 @@
+#include "G29Capture.hpp"
+#include "G29.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'G', '2', '9', 'C', 'A', 'P', 0, 0};
+const uint32_t kVersion = 1;
+
+} // namespace
+
+G29CaptureWriter::G29CaptureWriter(const std::string& path, size_t maxRecords)
+    : fd(-1), mapping(nullptr), mappingSize(0), capacity(maxRecords), reserved(0) {
+    if (maxRecords == 0) {
+        throw std::invalid_argument("Capture must hold at least one record");
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create capture file " + path);
+    }
+
+    mappingSize = sizeof(G29CaptureHeader) + maxRecords * sizeof(G29CaptureRecord);
+    if (::ftruncate(fd, static_cast<off_t>(mappingSize)) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to size capture file " + path);
+    }
+
+    void* address = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Failed to map capture file " + path);
+    }
+    mapping = static_cast<uint8_t*>(address);
+
+    G29CaptureHeader* header = reinterpret_cast<G29CaptureHeader*>(mapping);
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kVersion;
+    header->recordSize = sizeof(G29CaptureRecord);
+}
+
+G29CaptureWriter::~G29CaptureWriter() {
+    uint64_t written = recordCount();
+
+    G29CaptureHeader* header = reinterpret_cast<G29CaptureHeader*>(mapping);
+    header->recordCount = written;
+    header->droppedCount = droppedCount();
+
+    ::munmap(mapping, mappingSize);
+
+    // If trimming fails the header still holds the right count, and the
+    // zeroed records past it are ignored by G29Replay.
+    int trimmed = ::ftruncate(fd, static_cast<off_t>(sizeof(G29CaptureHeader) + written * sizeof(G29CaptureRecord)));
+    (void)trimmed;
+    ::close(fd);
+}
+
+bool G29CaptureWriter::append(G29RecordKind kind, uint64_t timestampNs, const uint8_t* data, size_t length) {
+    uint64_t index = reserved.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity) {
+        return false;
+    }
+
+    G29CaptureRecord* record = reinterpret_cast<G29CaptureRecord*>(mapping + sizeof(G29CaptureHeader)) + index;
+    record->timestampNs = timestampNs;
+    record->length = static_cast<uint8_t>(std::min(length, sizeof(record->data)));
+    std::memcpy(record->data, data, record->length);
+    record->kind = kind;
+    return true;
+}
+
+uint64_t G29CaptureWriter::recordCount() const {
+    return std::min<uint64_t>(reserved.load(std::memory_order_relaxed), capacity);
+}
+
+uint64_t G29CaptureWriter::droppedCount() const {
+    uint64_t total = reserved.load(std::memory_order_relaxed);
+    return total > capacity ? total - capacity : 0;
+}
+
+G29Replay::G29Replay(const std::string& path) : fd(-1), mapping(nullptr), mappingSize(0), count(0) {
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open capture file " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(G29CaptureHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a capture file: " + path);
+    }
+    mappingSize = static_cast<size_t>(info.st_size);
+
+    void* address = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Failed to map capture file " + path);
+    }
+    mapping = static_cast<const uint8_t*>(address);
+
+    const G29CaptureHeader* header = reinterpret_cast<const G29CaptureHeader*>(mapping);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion
+        || header->recordSize != sizeof(G29CaptureRecord)) {
+        ::munmap(const_cast<uint8_t*>(mapping), mappingSize);
+        ::close(fd);
+        throw std::runtime_error("Not a capture file: " + path);
+    }
+
+    // A capture that was never closed has no count; fall back to the file size.
+    size_t available = (mappingSize - sizeof(G29CaptureHeader)) / sizeof(G29CaptureRecord);
+    count = header->recordCount != 0 ? std::min<size_t>(header->recordCount, available) : available;
+}
+
+G29Replay::~G29Replay() {
+    ::munmap(const_cast<uint8_t*>(mapping), mappingSize);
+    ::close(fd);
+}
+
+size_t G29Replay::size() const {
+    return count;
+}
+
+const G29CaptureRecord& G29Replay::record(size_t index) const {
+    return reinterpret_cast<const G29CaptureRecord*>(mapping + sizeof(G29CaptureHeader))[index];
+}
+
+size_t G29Replay::play(G29& wheel, double speed) const {
+    if (wheel.isReaderRunning()) {
+        throw std::logic_error("Cannot replay into a wheel whose reader thread is running");
+    }
+
+    size_t replayed = 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t firstTimestamp = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const G29CaptureRecord& current = record(i);
+        if (current.kind != G29RecordKind::InputReport) {
+            continue;
+        }
+
+        if (replayed == 0) {
+            firstTimestamp = current.timestampNs;
+        } else if (speed > 0.0) {
+            auto offset = std::chrono::nanoseconds(static_cast<int64_t>((current.timestampNs - firstTimestamp) / speed));
+            std::this_thread::sleep_until(start + offset);
+        }
+
+        // Keep the recorded time so that filtering and the history see the original intervals.
+        auto recorded = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds(current.timestampNs));
+        wheel.processReport(current.data, current.length, std::chrono::steady_clock::time_point(recorded));
+        ++replayed;
+    }
+
+    return replayed;
+}
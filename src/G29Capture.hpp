@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class G29;
+
+/**
+ * @enum G29RecordKind
+ * @brief What a capture record holds.
+ */
+enum class G29RecordKind : uint8_t {
+    None = 0,  ///< Slot never written, for example after a crash.
+    InputReport = 1,  ///< A report read from the wheel by pump().
+    OutputMessage = 2  ///< A message written to the wheel.
+};
+
+/**
+ * @struct G29CaptureHeader
+ * @brief First bytes of a capture file.
+ */
+struct G29CaptureHeader {
+    char magic[8];  ///< "G29CAP" followed by two zero bytes.
+    uint32_t version;  ///< Format version, currently 1.
+    uint32_t recordSize;  ///< Size of one G29CaptureRecord, in bytes.
+    uint64_t recordCount;  ///< Number of records, written when the capture is closed.
+    uint64_t droppedCount;  ///< Records lost because the file was full.
+    uint8_t reserved[32];  ///< Zero, for future use.
+};
+
+/**
+ * @struct G29CaptureRecord
+ * @brief One fixed-size record of a capture file.
+ */
+struct G29CaptureRecord {
+    uint64_t timestampNs;  ///< Monotonic (steady_clock) time of the read or write, in nanoseconds.
+    G29RecordKind kind;  ///< What the record holds.
+    uint8_t length;  ///< Number of valid bytes in data.
+    uint8_t reserved[6];  ///< Zero, for future use.
+    uint8_t data[16];  ///< Raw report or message bytes.
+};
+
+static_assert(sizeof(G29CaptureHeader) == 64, "Capture header layout changed");
+static_assert(sizeof(G29CaptureRecord) == 32, "Capture record layout changed");
+
+/**
+ * @class G29CaptureWriter
+ * @brief Appends records to a capture file through a preallocated memory map.
+ *
+ * The whole file is sized and mapped when it is opened, so appending a record
+ * is a memory copy with no system call. Several threads may append at once.
+ * Records that do not fit are dropped and counted.
+ */
+class G29CaptureWriter {
+public:
+    /**
+     * @brief Creates the capture file and maps it.
+     *
+     * @param path The file to create, truncated if it exists.
+     * @param maxRecords The number of records to preallocate.
+     * @throw std::runtime_error if the file cannot be created or mapped.
+     * @throw std::invalid_argument if maxRecords is 0.
+     */
+    G29CaptureWriter(const std::string& path, size_t maxRecords);
+
+    /**
+     * @brief Destructor for the G29CaptureWriter class.
+     *
+     * Trims the file to the records written and unmaps it.
+     */
+    ~G29CaptureWriter();
+
+    G29CaptureWriter(const G29CaptureWriter&) = delete;
+    G29CaptureWriter& operator=(const G29CaptureWriter&) = delete;
+
+    /**
+     * @brief Appends a record.
+     *
+     * @param kind What the record holds.
+     * @param timestampNs Monotonic time of the read or write, in nanoseconds.
+     * @param data The bytes to record.
+     * @param length The number of bytes; anything past 16 is cut off.
+     * @return true if the record was written, false if the file was full.
+     */
+    bool append(G29RecordKind kind, uint64_t timestampNs, const uint8_t* data, size_t length);
+
+    /**
+     * @brief Gets the number of records written so far.
+     *
+     * @return The record count.
+     */
+    uint64_t recordCount() const;
+
+    /**
+     * @brief Gets the number of records dropped because the file was full.
+     *
+     * @return The dropped record count.
+     */
+    uint64_t droppedCount() const;
+
+private:
+    int fd;  ///< Capture file descriptor.
+    uint8_t* mapping;  ///< Start of the mapped file.
+    size_t mappingSize;  ///< Size of the mapped file, in bytes.
+    size_t capacity;  ///< Number of records the file holds.
+    std::atomic<uint64_t> reserved;  ///< Record slots handed out, including dropped ones.
+};
+
+/**
+ * @class G29Replay
+ * @brief Reads a capture file and feeds its input reports back to a G29.
+ */
+class G29Replay {
+public:
+    /**
+     * @brief Opens and maps a capture file.
+     *
+     * @param path The capture file.
+     * @throw std::runtime_error if the file cannot be opened, mapped or is not a capture.
+     */
+    explicit G29Replay(const std::string& path);
+
+    /**
+     * @brief Destructor for the G29Replay class.
+     *
+     * Unmaps the file.
+     */
+    ~G29Replay();
+
+    G29Replay(const G29Replay&) = delete;
+    G29Replay& operator=(const G29Replay&) = delete;
+
+    /**
+     * @brief Gets the number of records in the capture.
+     *
+     * @return The record count.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets a record.
+     *
+     * @param index The record index, below size().
+     * @return The record.
+     */
+    const G29CaptureRecord& record(size_t index) const;
+
+    /**
+     * @brief Feeds every input report through the wheel's decoder.
+     *
+     * Output records are skipped. Each report keeps its recorded timestamp,
+     * so filtering, the history and events see the original timing at any
+     * speed. The wheel's reader thread must not be running.
+     *
+     * @param wheel The wheel to decode the reports.
+     * @param speed Playback speed relative to the recording, or 0 to replay as
+     *              fast as possible.
+     * @return The number of input reports replayed.
+     * @throw std::logic_error if the wheel's reader thread is running.
+     */
+    size_t play(G29& wheel, double speed = 1.0) const;
+
+private:
+    int fd;  ///< Capture file descriptor.
+    const uint8_t* mapping;  ///< Start of the mapped file.
+    size_t mappingSize;  ///< Size of the mapped file, in bytes.
+    size_t count;  ///< Number of records.
+};
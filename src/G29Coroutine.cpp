@@ -0,0 +1,180 @@
+#include "G29Coroutine.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+constexpr std::chrono::milliseconds G29InputLoop::kRunSlice;
+const size_t G29InputLoop::kBatchSize;
+
+G29Task::G29Task(std::coroutine_handle<promise_type> handle) : handle(handle) {
+}
+
+G29Task::G29Task(G29Task&& other) noexcept : handle(other.handle) {
+    other.handle = nullptr;
+}
+
+G29Task& G29Task::operator=(G29Task&& other) noexcept {
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+G29Task::~G29Task() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+bool G29Task::done() const {
+    return !handle || handle.done();
+}
+
+void G29Task::get() const {
+    if (!done()) {
+        throw std::logic_error("G29Task has not finished");
+    }
+    if (handle && handle.promise().exception) {
+        std::rethrow_exception(handle.promise().exception);
+    }
+}
+
+G29InputAwaiter::G29InputAwaiter(G29InputLoop& loop, Kind kind, G29Button button, G29Axis axis, float threshold)
+    : loop(&loop), kind(kind), button(button), axis(axis), threshold(threshold), above(false), matched(false), event() {
+}
+
+G29InputAwaiter::~G29InputAwaiter() {
+    if (!loop || !waiting) {
+        return;
+    }
+
+    // Destroyed while suspended, e.g. with its task: forget it.
+    loop->waiting.erase(std::remove(loop->waiting.begin(), loop->waiting.end(), this), loop->waiting.end());
+    std::replace(loop->ready.begin(), loop->ready.end(), this, static_cast<G29InputAwaiter*>(nullptr));
+}
+
+void G29InputAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiting = handle;
+    if (kind == Kind::AxisCrosses) {
+        // Later reports of the batch are already in getState(); start from the one being delivered.
+        float value = loop->delivering ? loop->delivering->state.axisValue(axis) : loop->wheel.getState().axisValue(axis);
+        above = value >= threshold;
+    }
+    loop->waiting.push_back(this);
+}
+
+bool G29InputAwaiter::matches(const G29Event& report) {
+    switch (kind) {
+    case Kind::AnyReport:
+        matched = true;
+        break;
+    case Kind::ButtonPressed:
+        matched = (report.pressed & buttonMask(button)) != 0;
+        break;
+    case Kind::AxisCrosses: {
+        bool nowAbove = report.state.axisValue(axis) >= threshold;
+        matched = nowAbove != above;
+        above = nowAbove;
+        break;
+    }
+    }
+
+    if (matched) {
+        event = report;
+    }
+    return matched;
+}
+
+G29InputLoop::G29InputLoop(G29& wheel, size_t queueCapacity) : wheel(wheel), batch(kBatchSize), delivering(nullptr), stopRequested(false) {
+    wheel.enableEventQueue(queueCapacity);
+}
+
+G29InputLoop::~G29InputLoop() {
+    for (G29InputAwaiter* awaiter : waiting) {
+        awaiter->loop = nullptr;
+    }
+}
+
+G29InputAwaiter G29InputLoop::nextReport() {
+    return G29InputAwaiter(*this, G29InputAwaiter::Kind::AnyReport, G29Button::X, G29Axis::Steering, 0.0f);
+}
+
+G29InputAwaiter G29InputLoop::buttonPressed(G29Button button) {
+    return G29InputAwaiter(*this, G29InputAwaiter::Kind::ButtonPressed, button, G29Axis::Steering, 0.0f);
+}
+
+G29InputAwaiter G29InputLoop::axisCrosses(G29Axis axis, float threshold) {
+    if (axis >= G29Axis::Count) {
+        throw std::invalid_argument("Unknown axis");
+    }
+    return G29InputAwaiter(*this, G29InputAwaiter::Kind::AxisCrosses, G29Button::X, axis, threshold);
+}
+
+int G29InputLoop::fileDescriptor() const {
+    return wheel.fileDescriptor();
+}
+
+size_t G29InputLoop::dispatch() {
+    return runOnce(std::chrono::milliseconds(0));
+}
+
+size_t G29InputLoop::runOnce(std::chrono::milliseconds timeout) {
+    wheel.drain(timeout);
+
+    size_t dispatched = 0;
+    size_t count = 0;
+    while ((count = wheel.popEvents(batch.data(), batch.size())) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            deliver(batch[i]);
+        }
+        dispatched += count;
+    }
+    return dispatched;
+}
+
+void G29InputLoop::run() {
+    while (!stopRequested.exchange(false) && !waiting.empty()) {
+        runOnce(kRunSlice);
+    }
+}
+
+void G29InputLoop::stop() {
+    stopRequested = true;
+    wheel.wake();
+}
+
+size_t G29InputLoop::waitingCount() const {
+    return waiting.size();
+}
+
+void G29InputLoop::deliver(const G29Event& report) {
+    for (G29InputAwaiter* awaiter : waiting) {
+        if (awaiter->matches(report)) {
+            ready.push_back(awaiter);
+        }
+    }
+    if (ready.empty()) {
+        return;
+    }
+
+    waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+                                 [](const G29InputAwaiter* awaiter) { return awaiter->matched; }),
+                  waiting.end());
+
+    // A resumed task may destroy another ready one, which nulls its entry.
+    delivering = &report;
+    for (size_t i = 0; i < ready.size(); ++i) {
+        G29InputAwaiter* awaiter = ready[i];
+        if (!awaiter) {
+            continue;
+        }
+        ready[i] = nullptr;
+        awaiter->loop = nullptr;
+        awaiter->waiting.resume();
+    }
+    delivering = nullptr;
+    ready.clear();
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+// Optional C++20 layer: built as the G29Coroutine target when the compiler
+// supports coroutines. The G29 library itself stays C++11.
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <vector>
+#include "G29.hpp"
+
+class G29InputLoop;
+
+/**
+ * @class G29Task
+ * @brief A coroutine driven by wheel input, such as a menu or shift logic.
+ *
+ * The coroutine starts running as soon as it is called and runs until its
+ * first co_await on a G29InputLoop awaitable. Destroying the task destroys
+ * the coroutine, even if it is still waiting.
+ */
+class G29Task {
+public:
+    /// Coroutine promise of G29Task.
+    struct promise_type {
+        std::exception_ptr exception;  ///< Exception the coroutine ended with, if any.
+
+        G29Task get_return_object() {
+            return G29Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    G29Task(G29Task&& other) noexcept;
+    G29Task& operator=(G29Task&& other) noexcept;
+    G29Task(const G29Task&) = delete;
+    G29Task& operator=(const G29Task&) = delete;
+    ~G29Task();
+
+    /**
+     * @brief Checks if the coroutine has finished.
+     *
+     * @return true if it returned or threw, false if it is still waiting.
+     */
+    bool done() const;
+
+    /**
+     * @brief Rethrows the exception the coroutine ended with, if any.
+     *
+     * @throw std::logic_error if the coroutine has not finished.
+     */
+    void get() const;
+
+private:
+    explicit G29Task(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> handle;  ///< The coroutine, null once moved from.
+};
+
+/**
+ * @class G29InputAwaiter
+ * @brief Suspends a coroutine until a decoded report matches a condition.
+ *
+ * Returned by the G29InputLoop awaitables; co_await yields the matching
+ * report. Not meant to be kept around outside a co_await expression.
+ */
+class G29InputAwaiter {
+public:
+    /// What the awaiter waits for.
+    enum class Kind {
+        AnyReport,  ///< The next report.
+        ButtonPressed,  ///< A report on which a button goes down.
+        AxisCrosses  ///< A report on which an axis crosses a threshold.
+    };
+
+    G29InputAwaiter(G29InputLoop& loop, Kind kind, G29Button button, G29Axis axis, float threshold);
+    G29InputAwaiter(const G29InputAwaiter&) = delete;
+    G29InputAwaiter& operator=(const G29InputAwaiter&) = delete;
+    ~G29InputAwaiter();
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    G29Event await_resume() const noexcept { return event; }
+
+private:
+    friend class G29InputLoop;
+
+    /**
+     * @brief Checks a report against the condition.
+     *
+     * @param report The report.
+     * @return true if the waiting coroutine should resume with it.
+     */
+    bool matches(const G29Event& report);
+
+    G29InputLoop* loop;  ///< Loop the awaiter is registered with, null once resumed or detached.
+    Kind kind;  ///< What the awaiter waits for.
+    G29Button button;  ///< ButtonPressed only: the button.
+    G29Axis axis;  ///< AxisCrosses only: the axis.
+    float threshold;  ///< AxisCrosses only: the threshold.
+    bool above;  ///< AxisCrosses only: whether the axis was at or above the threshold.
+    bool matched;  ///< Whether a report satisfied the condition.
+    std::coroutine_handle<> waiting;  ///< The suspended coroutine.
+    G29Event event;  ///< The matching report.
+};
+
+/**
+ * @class G29InputLoop
+ * @brief Resumes coroutines as wheel reports arrive, on one thread, without polling.
+ *
+ * The loop reads reports with G29::drain() and hands every one of them, in
+ * order, to the coroutines waiting on it. Any number of tasks can wait at
+ * once; a report costs one check per waiting task.
+ *
+ * To use another event loop, watch fileDescriptor() for readability and
+ * call dispatch() when it fires. Otherwise run() blocks in the transport
+ * until reports arrive. Must not be used while the wheel's reader thread runs.
+ */
+class G29InputLoop {
+public:
+    /**
+     * @brief Constructor for the G29InputLoop class.
+     *
+     * Enables the wheel's event queue, so that no report between two
+     * dispatches is lost.
+     *
+     * @param wheel The wheel to read.
+     * @param queueCapacity Capacity of the wheel's event queue. Must be a power of two.
+     * @throw std::logic_error if the wheel's reader thread is running.
+     */
+    explicit G29InputLoop(G29& wheel, size_t queueCapacity = 1024);
+
+    /**
+     * @brief Destructor for the G29InputLoop class.
+     *
+     * Tasks still waiting are not resumed; destroy them to free them.
+     */
+    ~G29InputLoop();
+
+    G29InputLoop(const G29InputLoop&) = delete;
+    G29InputLoop& operator=(const G29InputLoop&) = delete;
+
+    /**
+     * @brief Waits for the next report.
+     *
+     * @return An awaitable yielding the report.
+     */
+    G29InputAwaiter nextReport();
+
+    /**
+     * @brief Waits for a button to go down.
+     *
+     * @param button The button.
+     * @return An awaitable yielding the report on which it went down.
+     */
+    G29InputAwaiter buttonPressed(G29Button button);
+
+    /**
+     * @brief Waits for a calibrated axis to cross a threshold, in either direction.
+     *
+     * @param axis The axis.
+     * @param threshold The threshold, in the axis' calibrated range.
+     * @return An awaitable yielding the report on which the axis crossed it.
+     */
+    G29InputAwaiter axisCrosses(G29Axis axis, float threshold);
+
+    /**
+     * @brief Gets the descriptor to watch in an external event loop.
+     *
+     * @return The wheel's file descriptor, or -1 if it has none.
+     */
+    int fileDescriptor() const;
+
+    /**
+     * @brief Reads the pending reports without blocking and resumes the tasks they satisfy.
+     *
+     * @return The number of reports dispatched.
+     * @throw std::runtime_error if reading from the device fails.
+     */
+    size_t dispatch();
+
+    /**
+     * @brief Waits up to a timeout for reports, then dispatches them.
+     *
+     * @param timeout The longest time to block in the transport.
+     * @return The number of reports dispatched.
+     * @throw std::runtime_error if reading from the device fails.
+     */
+    size_t runOnce(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Dispatches reports until stop() is called or no task is waiting.
+     *
+     * @throw std::runtime_error if reading from the device fails.
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return. Can be called from any thread.
+     */
+    void stop();
+
+    /**
+     * @brief Gets the number of tasks waiting on the loop.
+     *
+     * @return The waiting task count.
+     */
+    size_t waitingCount() const;
+
+private:
+    friend class G29InputAwaiter;
+
+    /**
+     * @brief Hands one report to the waiting tasks, resuming those it satisfies.
+     *
+     * @param report The report.
+     */
+    void deliver(const G29Event& report);
+
+    /// Longest single wait of run(), so that stop() is seen without a wake-up.
+    static constexpr std::chrono::milliseconds kRunSlice{100};
+    /// Reports popped from the wheel's event queue at a time.
+    static const size_t kBatchSize = 64;
+
+    G29& wheel;  ///< The wheel read.
+    std::vector<G29InputAwaiter*> waiting;  ///< Registered awaiters, in registration order.
+    std::vector<G29InputAwaiter*> ready;  ///< Scratch list of awaiters to resume.
+    std::vector<G29Event> batch;  ///< Scratch buffer for popped reports.
+    const G29Event* delivering;  ///< Report whose tasks are being resumed, null between reports.
+    std::atomic<bool> stopRequested;  ///< Set by stop().
+};
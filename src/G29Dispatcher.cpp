@@ -0,0 +1,170 @@
+#include "G29Dispatcher.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+const size_t G29Dispatcher::kButtonKeys;
+const size_t G29Dispatcher::kAxisCount;
+
+namespace {
+
+size_t bucketOf(size_t bit, bool pressed) {
+    return 2 * bit + (pressed ? 0 : 1);
+}
+
+size_t countBits(uint32_t bits) {
+#if defined(__GNUC__)
+    return static_cast<size_t>(__builtin_popcount(bits));
+#else
+    size_t count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/// Index of the lowest set bit; bits must not be 0.
+size_t lowestBit(uint32_t bits) {
+#if defined(__GNUC__)
+    return static_cast<size_t>(__builtin_ctz(bits));
+#else
+    size_t bit = 0;
+    while ((bits & (uint32_t(1) << bit)) == 0) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+} // namespace
+
+G29Dispatcher::G29Dispatcher(size_t capacity) : capacity(capacity), primed(false), nextId(1) {
+    buttons.reserve(capacity);
+    for (size_t& begin : bucketBegin) {
+        begin = 0;
+    }
+    for (size_t axis = 0; axis < kAxisCount; ++axis) {
+        axes[axis].reserve(capacity);
+        lastAxis[axis] = 0.0f;
+    }
+}
+
+G29Dispatcher::SubscriptionId G29Dispatcher::onButtons(uint32_t mask, G29ButtonEdge edge, ButtonHandler handler, void* context) {
+    const uint32_t allButtons = (uint32_t(1) << static_cast<size_t>(G29Button::Count)) - 1;
+    if (mask == 0 || (mask & ~allButtons) != 0) {
+        throw std::invalid_argument("Button mask must name at least one button and no others");
+    }
+    if (!handler) {
+        throw std::invalid_argument("G29Dispatcher needs a handler");
+    }
+    if (size() + countBits(mask) > capacity) {
+        throw std::length_error("G29Dispatcher handler table is full");
+    }
+
+    SubscriptionId id = nextId++;
+    ButtonEntry entry = {handler, context, id};
+    for (size_t bit = 0; bit < static_cast<size_t>(G29Button::Count); ++bit) {
+        if ((mask & (uint32_t(1) << bit)) == 0) {
+            continue;
+        }
+
+        // Append to the end of the bucket, keeping registration order.
+        size_t bucket = bucketOf(bit, edge == G29ButtonEdge::Press);
+        buttons.insert(buttons.begin() + bucketBegin[bucket + 1], entry);
+        for (size_t later = bucket + 1; later <= kButtonKeys; ++later) {
+            ++bucketBegin[later];
+        }
+    }
+    return id;
+}
+
+G29Dispatcher::SubscriptionId G29Dispatcher::onAxisCross(G29Axis axis, float threshold, AxisHandler handler, void* context) {
+    if (axis >= G29Axis::Count) {
+        throw std::invalid_argument("Unknown axis");
+    }
+    if (!handler) {
+        throw std::invalid_argument("G29Dispatcher needs a handler");
+    }
+    if (size() >= capacity) {
+        throw std::length_error("G29Dispatcher handler table is full");
+    }
+
+    SubscriptionId id = nextId++;
+    AxisEntry entry = {threshold, handler, context, id};
+    std::vector<AxisEntry>& entries = axes[static_cast<size_t>(axis)];
+    auto position = std::upper_bound(entries.begin(), entries.end(), threshold,
+                                     [](float value, const AxisEntry& other) { return value < other.threshold; });
+    entries.insert(position, entry);
+    return id;
+}
+
+void G29Dispatcher::unsubscribe(SubscriptionId id) {
+    for (size_t bucket = kButtonKeys; bucket-- > 0;) {
+        for (size_t i = bucketBegin[bucket + 1]; i-- > bucketBegin[bucket];) {
+            if (buttons[i].id != id) {
+                continue;
+            }
+            buttons.erase(buttons.begin() + i);
+            for (size_t later = bucket + 1; later <= kButtonKeys; ++later) {
+                --bucketBegin[later];
+            }
+        }
+    }
+
+    for (std::vector<AxisEntry>& entries : axes) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [id](const AxisEntry& entry) { return entry.id == id; }),
+                      entries.end());
+    }
+}
+
+void G29Dispatcher::dispatch(const G29Event& event) {
+    dispatchButtons(event.pressed, true, event);
+    dispatchButtons(event.released, false, event);
+
+    for (size_t axis = 0; axis < kAxisCount; ++axis) {
+        float value = event.state.axisValue(static_cast<G29Axis>(axis));
+        const std::vector<AxisEntry>& entries = axes[axis];
+        if (primed && !entries.empty() && value != lastAxis[axis]) {
+            size_t before = thresholdsBelow(entries, lastAxis[axis]);
+            size_t after = thresholdsBelow(entries, value);
+            // Crossed thresholds are those between the two values, called in the order they were passed.
+            for (size_t i = before; i < after; ++i) {
+                entries[i].handler(entries[i].context, static_cast<G29Axis>(axis), entries[i].threshold, true, event);
+            }
+            for (size_t i = before; i > after; --i) {
+                entries[i - 1].handler(entries[i - 1].context, static_cast<G29Axis>(axis), entries[i - 1].threshold, false, event);
+            }
+        }
+        lastAxis[axis] = value;
+    }
+    primed = true;
+}
+
+size_t G29Dispatcher::size() const {
+    size_t count = buttons.size();
+    for (const std::vector<AxisEntry>& entries : axes) {
+        count += entries.size();
+    }
+    return count;
+}
+
+void G29Dispatcher::dispatchButtons(uint32_t bits, bool pressed, const G29Event& event) const {
+    for (; bits != 0; bits &= bits - 1) {
+        size_t bit = lowestBit(bits);
+        if (bit >= static_cast<size_t>(G29Button::Count)) {
+            return;
+        }
+
+        size_t bucket = bucketOf(bit, pressed);
+        for (size_t i = bucketBegin[bucket]; i < bucketBegin[bucket + 1]; ++i) {
+            buttons[i].handler(buttons[i].context, static_cast<G29Button>(bit), pressed, event);
+        }
+    }
+}
+
+size_t G29Dispatcher::thresholdsBelow(const std::vector<AxisEntry>& entries, float value) {
+    auto end = std::upper_bound(entries.begin(), entries.end(), value,
+                                [](float v, const AxisEntry& entry) { return v < entry.threshold; });
+    return static_cast<size_t>(end - entries.begin());
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "G29State.hpp"
+
+/**
+ * @enum G29ButtonEdge
+ * @brief Which change of a button a handler reacts to.
+ */
+enum class G29ButtonEdge : uint8_t {
+    Press,  ///< The button goes down.
+    Release  ///< The button goes up.
+};
+
+/**
+ * @class G29Dispatcher
+ * @brief Calls handlers for button edges and axis threshold crossings.
+ *
+ * Handlers are plain function pointers with a context pointer, kept in one
+ * flat table bucketed by button and edge and allocated up front. A report
+ * only visits the buckets of the bits that changed, and for each axis the
+ * thresholds that lie between its previous and new value, so its cost grows
+ * with what changed rather than with the number of handlers.
+ *
+ * Buttons and axes are enums, so a misspelt one does not compile. The
+ * template overloads bind member functions at compile time:
+ *
+ * @code
+ * dispatcher.onButton<Gearbox, &Gearbox::shift>(G29Button::RightPaddle, G29ButtonEdge::Press, &gearbox);
+ * @endcode
+ *
+ * Subscribing and dispatching must not overlap; subscribe before handing
+ * the dispatcher to G29::setDispatcher() or while the reader is stopped.
+ */
+class G29Dispatcher {
+public:
+    /// Called with the button, whether it went down, and the report.
+    typedef void (*ButtonHandler)(void* context, G29Button button, bool pressed, const G29Event& event);
+    /// Called with the axis, the threshold, whether the axis rose through it, and the report.
+    typedef void (*AxisHandler)(void* context, G29Axis axis, float threshold, bool rising, const G29Event& event);
+    /// Identifies a subscription for unsubscribe().
+    typedef uint32_t SubscriptionId;
+
+    /**
+     * @brief Constructor for the G29Dispatcher class.
+     *
+     * @param capacity The most handler entries held: one per button of a
+     *                 button subscription, one per axis subscription.
+     */
+    explicit G29Dispatcher(size_t capacity = 64);
+
+    /**
+     * @brief Subscribes a handler to an edge of several buttons.
+     *
+     * @param mask The buttons, for example buttonMask(G29Button::L2, G29Button::R2).
+     * @param edge The edge to react to.
+     * @param handler The handler.
+     * @param context Passed to the handler as is.
+     * @return The subscription.
+     * @throw std::invalid_argument if mask is empty or has bits past the last button, or handler is null.
+     * @throw std::length_error if the table is full.
+     */
+    SubscriptionId onButtons(uint32_t mask, G29ButtonEdge edge, ButtonHandler handler, void* context);
+
+    /**
+     * @brief Subscribes a handler to an edge of one button.
+     *
+     * @param button The button.
+     * @param edge The edge to react to.
+     * @param handler The handler.
+     * @param context Passed to the handler as is.
+     * @return The subscription.
+     * @throw std::invalid_argument if handler is null.
+     * @throw std::length_error if the table is full.
+     */
+    SubscriptionId onButton(G29Button button, G29ButtonEdge edge, ButtonHandler handler, void* context) {
+        return onButtons(buttonMask(button), edge, handler, context);
+    }
+
+    /**
+     * @brief Subscribes a member function to an edge of one button.
+     *
+     * @tparam T The object type.
+     * @tparam Method The member function to call.
+     * @param button The button.
+     * @param edge The edge to react to.
+     * @param object The object to call it on.
+     * @return The subscription.
+     * @throw std::length_error if the table is full.
+     */
+    template <typename T, void (T::*Method)(G29Button, bool, const G29Event&)>
+    SubscriptionId onButton(G29Button button, G29ButtonEdge edge, T* object) {
+        return onButtons(buttonMask(button), edge, &callButton<T, Method>, object);
+    }
+
+    /**
+     * @brief Subscribes a handler to an axis crossing a threshold, in either direction.
+     *
+     * @param axis The axis.
+     * @param threshold The threshold, in the calibrated range of the axis.
+     *                  The axis is above it once its value is at least threshold.
+     * @param handler The handler.
+     * @param context Passed to the handler as is.
+     * @return The subscription.
+     * @throw std::invalid_argument if axis is unknown or handler is null.
+     * @throw std::length_error if the table is full.
+     */
+    SubscriptionId onAxisCross(G29Axis axis, float threshold, AxisHandler handler, void* context);
+
+    /**
+     * @brief Subscribes a member function to an axis crossing a threshold.
+     *
+     * @tparam T The object type.
+     * @tparam Method The member function to call.
+     * @param axis The axis.
+     * @param threshold The threshold.
+     * @param object The object to call it on.
+     * @return The subscription.
+     * @throw std::length_error if the table is full.
+     */
+    template <typename T, void (T::*Method)(G29Axis, float, bool, const G29Event&)>
+    SubscriptionId onAxisCross(G29Axis axis, float threshold, T* object) {
+        return onAxisCross(axis, threshold, &callAxis<T, Method>, object);
+    }
+
+    /**
+     * @brief Removes a subscription. Unknown subscriptions are ignored.
+     *
+     * @param id The subscription.
+     */
+    void unsubscribe(SubscriptionId id);
+
+    /**
+     * @brief Calls the handlers a report triggers.
+     *
+     * The first report only records the axes, since there is nothing to
+     * compare them with. Does not allocate.
+     *
+     * @param event The report, with its button edges.
+     */
+    void dispatch(const G29Event& event);
+
+    /**
+     * @brief Gets the number of handler entries in the table.
+     *
+     * @return The entry count, at most the capacity.
+     */
+    size_t size() const;
+
+private:
+    /// One button handler in the flat table.
+    struct ButtonEntry {
+        ButtonHandler handler;
+        void* context;
+        SubscriptionId id;
+    };
+
+    /// One axis handler, kept sorted by threshold per axis.
+    struct AxisEntry {
+        float threshold;
+        AxisHandler handler;
+        void* context;
+        SubscriptionId id;
+    };
+
+    /// Buckets of the button table: press and release of every button.
+    static const size_t kButtonKeys = 2 * static_cast<size_t>(G29Button::Count);
+    static const size_t kAxisCount = static_cast<size_t>(G29Axis::Count);
+
+    template <typename T, void (T::*Method)(G29Button, bool, const G29Event&)>
+    static void callButton(void* context, G29Button button, bool pressed, const G29Event& event) {
+        (static_cast<T*>(context)->*Method)(button, pressed, event);
+    }
+
+    template <typename T, void (T::*Method)(G29Axis, float, bool, const G29Event&)>
+    static void callAxis(void* context, G29Axis axis, float threshold, bool rising, const G29Event& event) {
+        (static_cast<T*>(context)->*Method)(axis, threshold, rising, event);
+    }
+
+    /**
+     * @brief Calls the handlers of one bucket for every bit of a mask.
+     *
+     * @param bits The buttons that took the edge.
+     * @param pressed Whether the edge is a press.
+     * @param event The report.
+     */
+    void dispatchButtons(uint32_t bits, bool pressed, const G29Event& event) const;
+
+    /**
+     * @brief Counts the thresholds of an axis at or below a value.
+     *
+     * @param entries The axis' entries, sorted by threshold.
+     * @param value The axis value.
+     * @return The number of thresholds the value is at or above.
+     */
+    static size_t thresholdsBelow(const std::vector<AxisEntry>& entries, float value);
+
+    size_t capacity;  ///< Most entries held, over buttons and axes.
+    std::vector<ButtonEntry> buttons;  ///< Button handlers, grouped by bucket in bucket order.
+    size_t bucketBegin[kButtonKeys + 1];  ///< Start of each bucket in buttons; the last is the end.
+    std::vector<AxisEntry> axes[kAxisCount];  ///< Axis handlers per axis, sorted by threshold.
+    float lastAxis[kAxisCount];  ///< Axis values at the previous report.
+    bool primed;  ///< Whether lastAxis holds a report.
+    SubscriptionId nextId;  ///< Identifier of the next subscription.
+};
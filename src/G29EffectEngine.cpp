@@ -0,0 +1,148 @@
+#include "G29EffectEngine.hpp"
+#include <algorithm>
+#include <stdexcept>
+#ifdef __unix__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+G29EffectEngine::G29EffectEngine(G29& wheel)
+    : wheel(wheel), running(false), period(std::chrono::milliseconds(1)),
+      ticks(0), overruns(0), lastJitterNs(0), maxJitterNs(0), totalJitterNs(0), realtime(false) {
+    G29ConditionEffects none = {};
+    none.maxForce = 1.0f;
+    effects.store(none);
+}
+
+G29EffectEngine::~G29EffectEngine() {
+    stop();
+}
+
+void G29EffectEngine::setEffects(const G29ConditionEffects& newEffects) {
+    effects.store(newEffects);
+}
+
+G29ConditionEffects G29EffectEngine::getEffects() const {
+    return effects.load();
+}
+
+G29EffectScheduler& G29EffectEngine::periodicEffects() {
+    return periodic;
+}
+
+void G29EffectEngine::start(unsigned rateHz, int realtimePriority) {
+    if (rateHz == 0) {
+        throw std::invalid_argument("Rate must be greater than 0");
+    }
+    if (running.exchange(true)) {
+        return;
+    }
+
+    period = std::chrono::nanoseconds(1000000000 / rateHz);
+    wheel.startForceFeedbackWriter();
+    loop = std::thread(&G29EffectEngine::run, this);
+
+    realtime = false;
+#ifdef __unix__
+    if (realtimePriority > 0) {
+        sched_param param = {};
+        param.sched_priority = realtimePriority;
+        realtime = pthread_setschedparam(loop.native_handle(), SCHED_FIFO, &param) == 0;
+    }
+#else
+    (void)realtimePriority;
+#endif
+}
+
+void G29EffectEngine::stop() {
+    running = false;
+    if (loop.joinable()) {
+        loop.join();
+        // Otherwise the wheel keeps pushing with the last force the loop sent.
+        wheel.forceFeedbackConstantAsync(toConstantForce(0.0f));
+    }
+}
+
+bool G29EffectEngine::isRunning() const {
+    return running;
+}
+
+G29EffectEngineStats G29EffectEngine::getStats() const {
+    G29EffectEngineStats stats;
+    stats.ticks = ticks.load(std::memory_order_relaxed);
+    stats.overruns = overruns.load(std::memory_order_relaxed);
+    stats.lastJitterNs = lastJitterNs.load(std::memory_order_relaxed);
+    stats.maxJitterNs = maxJitterNs.load(std::memory_order_relaxed);
+    stats.totalJitterNs = totalJitterNs.load(std::memory_order_relaxed);
+    stats.realtime = realtime.load(std::memory_order_relaxed);
+    return stats;
+}
+
+float G29EffectEngine::computeForce(const G29ConditionEffects& effects, float position, float velocity, float acceleration) {
+    float force = -effects.springStiffness * (position - effects.springCenter);
+    force -= effects.damping * velocity;
+    force -= effects.inertia * acceleration;
+
+    // Ramp friction in around zero velocity so that it does not chatter at rest.
+    float direction = std::max(-1.0f, std::min(1.0f, velocity / kFrictionVelocity));
+    force -= effects.friction * direction;
+
+    return std::max(-effects.maxForce, std::min(effects.maxForce, force));
+}
+
+float G29EffectEngine::toConstantForce(float force) {
+    force = std::max(-1.0f, std::min(1.0f, force));
+    return (force + 1.0f) * 0.5f;
+}
+
+float G29EffectEngine::steeringPosition(const G29State& state) {
+    return state.steeringAxis;
+}
+
+void G29EffectEngine::run() {
+    G29State state = wheel.getState();
+    float position = steeringPosition(state);
+    float velocity = 0.0f;
+    float acceleration = 0.0f;
+
+    auto lastTick = std::chrono::steady_clock::now();
+    auto next = lastTick;
+
+    while (running) {
+        next += period;
+        std::this_thread::sleep_until(next);
+
+        auto now = std::chrono::steady_clock::now();
+        uint64_t jitter = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - next).count());
+        if (now - next > period) {
+            // Skip the missed ticks instead of bursting to catch up.
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            next = now;
+        }
+        lastJitterNs.store(jitter, std::memory_order_relaxed);
+        totalJitterNs.fetch_add(jitter, std::memory_order_relaxed);
+        if (jitter > maxJitterNs.load(std::memory_order_relaxed)) {
+            maxJitterNs.store(jitter, std::memory_order_relaxed);
+        }
+
+        float dt = std::chrono::duration<float>(now - lastTick).count();
+        lastTick = now;
+
+        state = wheel.getState();
+        float newPosition = steeringPosition(state);
+        if (dt > 0.0f) {
+            float newVelocity = (newPosition - position) / dt;
+            float newAcceleration = (newVelocity - velocity) / dt;
+            velocity += kDerivativeSmoothing * (newVelocity - velocity);
+            acceleration += kDerivativeSmoothing * (newAcceleration - acceleration);
+        }
+        position = newPosition;
+
+        G29ConditionEffects current = effects.load();
+        float force = computeForce(current, position, velocity, acceleration) + periodic.sample(now);
+        force = std::max(-current.maxForce, std::min(current.maxForce, force));
+        wheel.forceFeedbackConstantAsync(toConstantForce(force));
+
+        ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "G29.hpp"
+#include "G29EffectScheduler.hpp"
+#include "SeqLock.hpp"
+
+/**
+ * @struct G29ConditionEffects
+ * @brief Coefficients of the effects computed by G29EffectEngine.
+ *
+ * Positions are normalized to -1..1 over the steering range and forces to
+ * -1..1 of the wheel's full constant force, positive pushing towards positive
+ * positions.
+ */
+struct G29ConditionEffects {
+    float springStiffness;  ///< Force per unit of distance from springCenter.
+    float springCenter;  ///< Rest position of the spring, from -1 to 1.
+    float damping;  ///< Force per unit of velocity, in positions per second.
+    float friction;  ///< Force opposing any motion, independent of speed.
+    float inertia;  ///< Force per unit of acceleration, in positions per second squared.
+    float maxForce;  ///< Limit applied to the summed force, from 0 to 1.
+};
+
+/**
+ * @struct G29EffectEngineStats
+ * @brief Timing counters of the effect engine control loop.
+ */
+struct G29EffectEngineStats {
+    uint64_t ticks;  ///< Number of control loop iterations.
+    uint64_t overruns;  ///< Ticks that started more than a full period late.
+    uint64_t lastJitterNs;  ///< Lateness of the last tick.
+    uint64_t maxJitterNs;  ///< Largest lateness seen.
+    uint64_t totalJitterNs;  ///< Sum of all latenesses, for computing the mean.
+    bool realtime;  ///< Whether the loop got the requested real-time priority.
+};
+
+/**
+ * @class G29EffectEngine
+ * @brief Host-side spring, damper, friction and inertia effects for the G29.
+ *
+ * Runs a fixed-rate control loop that reads the latest steering from the
+ * wheel, estimates its velocity and acceleration, and streams the resulting
+ * constant force through the wheel's force feedback writer. Periodic effects
+ * started on periodicEffects() are added to it. All state is allocated up
+ * front; a tick does not allocate.
+ */
+class G29EffectEngine {
+public:
+    /**
+     * @brief Constructor for the G29EffectEngine class.
+     *
+     * @param wheel The wheel to read steering from and send forces to. Must
+     *              outlive the engine.
+     */
+    explicit G29EffectEngine(G29& wheel);
+
+    /**
+     * @brief Destructor for the G29EffectEngine class.
+     *
+     * Stops the control loop, see stop().
+     */
+    ~G29EffectEngine();
+
+    /**
+     * @brief Sets the effect coefficients, picked up by the next tick.
+     *
+     * Must only be called from one thread at a time.
+     *
+     * @param effects The new coefficients.
+     */
+    void setEffects(const G29ConditionEffects& effects);
+
+    /**
+     * @brief Gets the current effect coefficients.
+     *
+     * @return The coefficients.
+     */
+    G29ConditionEffects getEffects() const;
+
+    /**
+     * @brief Gets the periodic effects mixed into every tick.
+     *
+     * @return The scheduler; start() and stop() effects from one thread at a time.
+     */
+    G29EffectScheduler& periodicEffects();
+
+    /**
+     * @brief Starts the control loop, and the wheel's force feedback writer.
+     *
+     * Does nothing if the loop is already running.
+     *
+     * @param rateHz The control loop rate, for example 500 or 1000.
+     * @param realtimePriority SCHED_FIFO priority for the loop thread, or 0 to
+     *                         keep the default scheduling. Failing to get it
+     *                         is not an error; see G29EffectEngineStats::realtime.
+     * @throw std::invalid_argument if rateHz is 0.
+     */
+    void start(unsigned rateHz = 1000, int realtimePriority = 0);
+
+    /**
+     * @brief Stops the control loop and waits for it to exit.
+     *
+     * If the loop was running, a neutral force is queued on the wheel's force
+     * feedback writer before returning, so the wheel does not keep the last
+     * force. The writer is left running.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the control loop is running.
+     *
+     * @return true if the loop is running, false otherwise.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Gets the timing counters of the control loop.
+     *
+     * @return A copy of the counters.
+     */
+    G29EffectEngineStats getStats() const;
+
+    /**
+     * @brief Computes the summed force for a given wheel motion.
+     *
+     * @param effects The effect coefficients.
+     * @param position The normalized steering position, from -1 to 1.
+     * @param velocity The steering velocity, in positions per second.
+     * @param acceleration The steering acceleration, in positions per second squared.
+     * @return The force, clamped to the effect's maxForce.
+     */
+    static float computeForce(const G29ConditionEffects& effects, float position, float velocity, float acceleration);
+
+    /**
+     * @brief Converts a signed force to the value expected by forceFeedbackConstant().
+     *
+     * @param force The force, from -1 to 1.
+     * @return The constant force value, from 0 to 1, where 0.5 is no force.
+     */
+    static float toConstantForce(float force);
+
+private:
+    /// Velocity below which friction ramps up linearly instead of switching sign.
+    static constexpr float kFrictionVelocity = 0.05f;
+    /// Weight of the newest sample in the velocity and acceleration estimates.
+    static constexpr float kDerivativeSmoothing = 0.2f;
+
+    G29& wheel;  ///< The wheel driven by the engine.
+    SeqLock<G29ConditionEffects> effects;  ///< Coefficients, readable by the loop without locking.
+    G29EffectScheduler periodic;  ///< Periodic effects added to the condition effects.
+    std::thread loop;  ///< Control loop thread.
+    std::atomic<bool> running;  ///< Whether the control loop should keep running.
+    std::chrono::nanoseconds period;  ///< Time between two ticks.
+
+    std::atomic<uint64_t> ticks;  ///< See G29EffectEngineStats::ticks.
+    std::atomic<uint64_t> overruns;  ///< See G29EffectEngineStats::overruns.
+    std::atomic<uint64_t> lastJitterNs;  ///< See G29EffectEngineStats::lastJitterNs.
+    std::atomic<uint64_t> maxJitterNs;  ///< See G29EffectEngineStats::maxJitterNs.
+    std::atomic<uint64_t> totalJitterNs;  ///< See G29EffectEngineStats::totalJitterNs.
+    std::atomic<bool> realtime;  ///< See G29EffectEngineStats::realtime.
+
+    /**
+     * @brief Gets the calibrated steering of a wheel state, from -1 to 1.
+     *
+     * @param state The wheel state.
+     * @return The normalized position.
+     */
+    static float steeringPosition(const G29State& state);
+
+    /**
+     * @brief Body of the control loop thread.
+     */
+    void run();
+};
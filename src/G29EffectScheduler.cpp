@@ -0,0 +1,155 @@
+#include "G29EffectScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+const size_t G29EffectScheduler::kTableSize;
+
+namespace {
+
+const size_t kTabulatedWaveforms = static_cast<size_t>(G29Waveform::SawtoothDown) + 1;
+
+/// One period of every tabulated waveform, with the first entry repeated at
+/// the end so that interpolation never wraps.
+struct WaveformTables {
+    float values[kTabulatedWaveforms][G29EffectScheduler::kTableSize + 1];
+
+    WaveformTables() {
+        const double pi = 3.14159265358979323846;
+        const size_t size = G29EffectScheduler::kTableSize;
+        for (size_t i = 0; i <= size; ++i) {
+            double phase = static_cast<double>(i % size) / size;
+            values[static_cast<size_t>(G29Waveform::Sine)][i] = static_cast<float>(std::sin(2.0 * pi * phase));
+            values[static_cast<size_t>(G29Waveform::Square)][i] = phase < 0.5 ? 1.0f : -1.0f;
+            values[static_cast<size_t>(G29Waveform::Triangle)][i] = static_cast<float>(std::fabs(4.0 * phase - 2.0) - 1.0);
+            values[static_cast<size_t>(G29Waveform::SawtoothUp)][i] = static_cast<float>(2.0 * phase - 1.0);
+            values[static_cast<size_t>(G29Waveform::SawtoothDown)][i] = static_cast<float>(1.0 - 2.0 * phase);
+        }
+    }
+};
+
+const WaveformTables kWaveformTables;
+
+int64_t toNanoseconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+int64_t toNanoseconds(std::chrono::milliseconds duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+} // namespace
+
+G29EffectScheduler::G29EffectScheduler(size_t capacity) : slots(capacity), owned(capacity) {
+    for (Slot& slot : owned) {
+        slot = Slot();
+    }
+}
+
+G29EffectScheduler::EffectId G29EffectScheduler::start(const G29PeriodicEffect& effect, std::chrono::steady_clock::time_point at) {
+    if (effect.frequencyHz < 0.0f) {
+        throw std::invalid_argument("Frequency must not be negative");
+    }
+    if (effect.envelope.fadeTime.count() > 0 && effect.duration.count() <= 0) {
+        throw std::invalid_argument("A fade needs a duration");
+    }
+
+    int64_t atNs = toNanoseconds(at);
+    for (size_t index = 0; index < owned.size(); ++index) {
+        Slot& slot = owned[index];
+        if (slot.active && slot.endNs > atNs) {
+            continue;
+        }
+
+        slot.effect = effect;
+        slot.startNs = atNs + toNanoseconds(effect.startDelay);
+        slot.endNs = effect.duration.count() > 0 ? slot.startNs + toNanoseconds(effect.duration)
+                                                 : std::numeric_limits<int64_t>::max();
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        slot.active = true;
+        slots[index].store(slot);
+        return (static_cast<EffectId>(slot.generation) << 32) | index;
+    }
+
+    throw std::length_error("Every effect slot is playing");
+}
+
+bool G29EffectScheduler::stop(EffectId id) {
+    size_t index = static_cast<size_t>(id & 0xFFFFFFFFu);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= owned.size() || !owned[index].active || owned[index].generation != generation) {
+        return false;
+    }
+
+    owned[index].active = false;
+    slots[index].store(owned[index]);
+    return owned[index].endNs > toNanoseconds(std::chrono::steady_clock::now());
+}
+
+void G29EffectScheduler::stopAll() {
+    for (size_t index = 0; index < owned.size(); ++index) {
+        if (owned[index].active) {
+            owned[index].active = false;
+            slots[index].store(owned[index]);
+        }
+    }
+}
+
+float G29EffectScheduler::sample(std::chrono::steady_clock::time_point now) const {
+    int64_t nowNs = toNanoseconds(now);
+    float force = 0.0f;
+    for (const SeqLock<Slot>& slot : slots) {
+        force += sampleSlot(slot.load(), nowNs);
+    }
+    return std::max(-1.0f, std::min(1.0f, force));
+}
+
+float G29EffectScheduler::waveformValue(G29Waveform waveform, double phase) {
+    size_t table = static_cast<size_t>(waveform);
+    if (table >= kTabulatedWaveforms) {
+        return 1.0f;
+    }
+
+    double position = (phase - std::floor(phase)) * kTableSize;
+    size_t index = std::min(static_cast<size_t>(position), kTableSize - 1);
+    float fraction = static_cast<float>(position - index);
+    const float* values = kWaveformTables.values[table];
+
+    // Interpolating would smear the square wave's edges; hold instead.
+    if (waveform == G29Waveform::Square) {
+        return values[index];
+    }
+    return values[index] + fraction * (values[index + 1] - values[index]);
+}
+
+float G29EffectScheduler::sampleSlot(const Slot& slot, int64_t nowNs) {
+    if (!slot.active || nowNs < slot.startNs || nowNs >= slot.endNs) {
+        return 0.0f;
+    }
+
+    const G29PeriodicEffect& effect = slot.effect;
+    double elapsed = (nowNs - slot.startNs) * 1e-9;
+    double remaining = (slot.endNs - nowNs) * 1e-9;
+
+    float wave = 0.0f;
+    if (effect.waveform == G29Waveform::Ramp) {
+        wave = effect.duration.count() > 0 ? static_cast<float>(2.0 * elapsed * 1000.0 / effect.duration.count() - 1.0) : 1.0f;
+    } else {
+        wave = waveformValue(effect.waveform, effect.phase + effect.frequencyHz * elapsed);
+    }
+
+    float gain = 1.0f;
+    const G29Envelope& envelope = effect.envelope;
+    double attack = envelope.attackTime.count() * 1e-3;
+    double fade = envelope.fadeTime.count() * 1e-3;
+    if (attack > 0.0 && elapsed < attack) {
+        gain = envelope.attackLevel + (1.0f - envelope.attackLevel) * static_cast<float>(elapsed / attack);
+    } else if (fade > 0.0 && remaining < fade) {
+        gain = envelope.fadeLevel + (1.0f - envelope.fadeLevel) * static_cast<float>(remaining / fade);
+    }
+
+    return effect.offset + effect.magnitude * gain * wave;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SeqLock.hpp"
+
+/**
+ * @enum G29Waveform
+ * @brief Shape of a periodic effect, from -1 to 1 over one period.
+ */
+enum class G29Waveform : uint8_t {
+    Sine,
+    Square,  ///< 1 over the first half period, -1 over the second.
+    Triangle,  ///< 1 at the start of the period, -1 halfway.
+    SawtoothUp,  ///< From -1 to 1 over the period.
+    SawtoothDown,  ///< From 1 to -1 over the period.
+    Ramp,  ///< From -1 to 1 over the whole duration, ignoring the frequency.
+    Constant  ///< Always 1.
+};
+
+/**
+ * @struct G29Envelope
+ * @brief Scales the magnitude of an effect at its start and end.
+ *
+ * Levels are fractions of the magnitude, from 0 to 1.
+ */
+struct G29Envelope {
+    float attackLevel;  ///< Level at the start, rising to 1 over attackTime.
+    std::chrono::milliseconds attackTime;  ///< Length of the attack, 0 for none.
+    float fadeLevel;  ///< Level at the end, reached from 1 over fadeTime.
+    std::chrono::milliseconds fadeTime;  ///< Length of the fade, 0 for none; needs a duration.
+};
+
+/**
+ * @struct G29PeriodicEffect
+ * @brief A timed effect mixed by G29EffectScheduler.
+ *
+ * Forces are normalized like G29ConditionEffects: -1 to 1 of the wheel's
+ * full constant force.
+ */
+struct G29PeriodicEffect {
+    G29Waveform waveform;  ///< The shape.
+    float magnitude;  ///< Peak force of the waveform; negative flips it.
+    float offset;  ///< Force added to the waveform.
+    float frequencyHz;  ///< Periods per second.
+    float phase;  ///< Position in the period at the start, from 0 to 1.
+    std::chrono::milliseconds startDelay;  ///< Time from start() to the effect playing.
+    std::chrono::milliseconds duration;  ///< How long the effect plays, 0 for until stopped.
+    G29Envelope envelope;  ///< Magnitude envelope.
+};
+
+/**
+ * @class G29EffectScheduler
+ * @brief Mixes any number of timed periodic effects into one force.
+ *
+ * Effects live in a fixed number of slots allocated up front. Waveforms are
+ * sampled from precomputed tables at the time passed to sample(), not at a
+ * tick count, so a late tick still lands on the right point of every
+ * waveform. Sampling does not allocate or lock and may run on another thread
+ * than start() and stop(). G29EffectEngine adds the mix to its forces.
+ */
+class G29EffectScheduler {
+public:
+    /// Identifies a started effect; 0 is never used.
+    typedef uint64_t EffectId;
+
+    /// Number of entries per waveform period in the lookup tables.
+    static const size_t kTableSize = 1024;
+
+    /**
+     * @brief Constructor for the G29EffectScheduler class.
+     *
+     * @param capacity The number of effects that can play at once.
+     */
+    explicit G29EffectScheduler(size_t capacity = 32);
+
+    /**
+     * @brief Starts an effect.
+     *
+     * Must only be called from one thread at a time, along with stop().
+     *
+     * @param effect The effect.
+     * @param at When the effect starts, before its start delay.
+     * @return The ID of the effect, for stop().
+     * @throw std::invalid_argument if the frequency is negative or the fade
+     *        needs a duration the effect does not have.
+     * @throw std::length_error if every slot holds an effect still playing.
+     */
+    EffectId start(const G29PeriodicEffect& effect,
+                   std::chrono::steady_clock::time_point at = std::chrono::steady_clock::now());
+
+    /**
+     * @brief Stops an effect.
+     *
+     * @param id The ID returned by start().
+     * @return true if the effect was stopped, false if it had already ended.
+     */
+    bool stop(EffectId id);
+
+    /**
+     * @brief Stops every effect.
+     */
+    void stopAll();
+
+    /**
+     * @brief Sums the forces of every effect playing at a given time.
+     *
+     * @param now The time to sample at.
+     * @return The summed force, clamped to -1..1.
+     */
+    float sample(std::chrono::steady_clock::time_point now) const;
+
+    /**
+     * @brief Samples a waveform table.
+     *
+     * @param waveform The waveform; Ramp and Constant are not tabulated and read as 1.
+     * @param phase The position in the period, wrapped to 0..1.
+     * @return The waveform value, from -1 to 1.
+     */
+    static float waveformValue(G29Waveform waveform, double phase);
+
+private:
+    /// An effect and when it plays, as shared with sample().
+    struct Slot {
+        G29PeriodicEffect effect;
+        int64_t startNs;  ///< When the effect starts playing, after its delay.
+        int64_t endNs;  ///< When the effect ends, INT64_MAX if it has no duration.
+        uint32_t generation;  ///< Incremented every time the slot is reused.
+        bool active;  ///< Whether the slot holds an effect.
+    };
+
+    std::vector<SeqLock<Slot>> slots;  ///< Effects, readable by sample() without locking.
+    std::vector<Slot> owned;  ///< Writer-side copy of the slots, to find free ones without loading them.
+
+    /**
+     * @brief Computes the force of one effect.
+     *
+     * @param slot The effect.
+     * @param nowNs The time to sample at.
+     * @return The force, 0 if the effect is not playing.
+     */
+    static float sampleSlot(const Slot& slot, int64_t nowNs);
+};
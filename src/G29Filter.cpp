@@ -0,0 +1,103 @@
+#include "G29Filter.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+const float kPi = 3.14159265358979f;
+
+/// Weight of the new sample of a first-order low-pass filter with the given cutoff.
+float smoothing(float cutoffHz, float dtSeconds) {
+    float tau = 1.0f / (2.0f * kPi * cutoffHz);
+    return 1.0f / (1.0f + tau / dtSeconds);
+}
+
+} // namespace
+
+G29AxisFilterState::G29AxisFilterState() : filter(defaultFilter()) {
+    reset();
+}
+
+void G29AxisFilterState::configure(const G29AxisFilter& filter) {
+    if (filter.kind != G29FilterKind::None && !(filter.minCutoffHz > 0.0f)) {
+        throw std::invalid_argument("Filter cutoff must be greater than 0");
+    }
+    if (!(filter.derivativeCutoffHz > 0.0f)) {
+        throw std::invalid_argument("Derivative cutoff must be greater than 0");
+    }
+    if (filter.beta < 0.0f) {
+        throw std::invalid_argument("Filter beta must not be negative");
+    }
+    if (filter.deadband < 0.0f || filter.deadband >= 1.0f) {
+        throw std::out_of_range("Deadband must be in range of 0 to 1");
+    }
+
+    this->filter = filter;
+    reset();
+}
+
+void G29AxisFilterState::reset() {
+    primed = false;
+    input = 0.0f;
+    inputVelocity = 0.0f;
+    output = 0.0f;
+    outputVelocity = 0.0f;
+    outputAcceleration = 0.0f;
+}
+
+float G29AxisFilterState::update(float value, float dtSeconds) {
+    if (!primed || !(dtSeconds > 0.0f)) {
+        reset();
+        primed = true;
+        input = value;
+        output = value;
+        return output;
+    }
+
+    float derivativeWeight = smoothing(filter.derivativeCutoffHz, dtSeconds);
+
+    float next = value;
+    if (std::fabs(value - output) < filter.deadband) {
+        next = output;
+    } else if (filter.kind != G29FilterKind::None) {
+        float cutoff = filter.minCutoffHz;
+        if (filter.kind == G29FilterKind::OneEuro) {
+            inputVelocity += derivativeWeight * ((value - input) / dtSeconds - inputVelocity);
+            cutoff += filter.beta * std::fabs(inputVelocity);
+        }
+        next = output + smoothing(cutoff, dtSeconds) * (value - output);
+    }
+    input = value;
+
+    float velocity = outputVelocity + derivativeWeight * ((next - output) / dtSeconds - outputVelocity);
+    outputAcceleration += derivativeWeight * ((velocity - outputVelocity) / dtSeconds - outputAcceleration);
+    outputVelocity = velocity;
+    output = next;
+    return output;
+}
+
+float G29AxisFilterState::value() const {
+    return output;
+}
+
+float G29AxisFilterState::velocity() const {
+    return outputVelocity;
+}
+
+float G29AxisFilterState::acceleration() const {
+    return outputAcceleration;
+}
+
+const G29AxisFilter& G29AxisFilterState::settings() const {
+    return filter;
+}
+
+G29AxisFilter G29AxisFilterState::defaultFilter() {
+    G29AxisFilter filter = {};
+    filter.kind = G29FilterKind::None;
+    filter.minCutoffHz = 1.0f;
+    filter.beta = 0.0f;
+    filter.derivativeCutoffHz = 10.0f;
+    filter.deadband = 0.0f;
+    return filter;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @enum G29FilterKind
+ * @brief How an axis is smoothed by the filter stage.
+ */
+enum class G29FilterKind : uint8_t {
+    None,  ///< No smoothing; the filtered value is the calibrated one.
+    Ema,  ///< Exponential moving average with a fixed cutoff frequency.
+    OneEuro  ///< One-Euro filter: the cutoff rises with speed, so fast moves lag less.
+};
+
+/**
+ * @struct G29AxisFilter
+ * @brief Settings of the filter applied to one calibrated axis, once per report.
+ *
+ * Cutoffs are in hertz rather than per-report weights, so the same settings
+ * behave the same whatever the report rate.
+ */
+struct G29AxisFilter {
+    G29FilterKind kind;  ///< How the axis is smoothed.
+    float minCutoffHz;  ///< Cutoff at rest for OneEuro, the fixed cutoff for Ema.
+    float beta;  ///< OneEuro only: cutoff added per unit of speed (axis units per second).
+    float derivativeCutoffHz;  ///< Cutoff used to smooth the velocity and acceleration.
+    float deadband;  ///< Inputs closer than this to the filtered value are held back, from 0 to 1.
+};
+
+/**
+ * @class G29AxisFilterState
+ * @brief Incremental filter and differentiator for one axis.
+ *
+ * Keeps O(1) state: the last output, velocity and acceleration.
+ */
+class G29AxisFilterState {
+public:
+    /**
+     * @brief Constructor for the G29AxisFilterState class, without smoothing.
+     */
+    G29AxisFilterState();
+
+    /**
+     * @brief Changes the settings and forgets the history.
+     *
+     * @param filter The new settings.
+     * @throw std::invalid_argument if a cutoff is not positive, beta is
+     *        negative or deadband is outside 0 to 1.
+     */
+    void configure(const G29AxisFilter& filter);
+
+    /**
+     * @brief Forgets the history, so the next update starts afresh.
+     */
+    void reset();
+
+    /**
+     * @brief Filters one sample.
+     *
+     * @param value The calibrated axis value.
+     * @param dtSeconds Time since the previous sample, in seconds; the history
+     *                  is restarted if it is not positive.
+     * @return The filtered value.
+     */
+    float update(float value, float dtSeconds);
+
+    /**
+     * @brief Gets the last filtered value.
+     *
+     * @return The filtered value.
+     */
+    float value() const;
+
+    /**
+     * @brief Gets the smoothed rate of change of the filtered value.
+     *
+     * @return The velocity, in axis units per second.
+     */
+    float velocity() const;
+
+    /**
+     * @brief Gets the smoothed rate of change of the velocity.
+     *
+     * @return The acceleration, in axis units per second squared.
+     */
+    float acceleration() const;
+
+    /**
+     * @brief Gets the settings.
+     *
+     * @return The settings given to configure().
+     */
+    const G29AxisFilter& settings() const;
+
+    /**
+     * @brief Gets the settings with no smoothing, no deadband and a 10 Hz derivative cutoff.
+     *
+     * @return The default settings.
+     */
+    static G29AxisFilter defaultFilter();
+
+private:
+    G29AxisFilter filter;  ///< Current settings.
+    bool primed;  ///< Whether a sample has been seen since the last reset.
+    float input;  ///< Last raw input, for the OneEuro speed estimate.
+    float inputVelocity;  ///< Smoothed speed of the raw input, for OneEuro.
+    float output;  ///< Last filtered value.
+    float outputVelocity;  ///< Smoothed derivative of the filtered value.
+    float outputAcceleration;  ///< Smoothed derivative of the velocity.
+};
@@ -0,0 +1,112 @@
+#include "G29History.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+float lerp(float from, float to, float weight) {
+    return from + (to - from) * weight;
+}
+
+float clampAxis(float value, float low) {
+    return std::max(low, std::min(1.0f, value));
+}
+
+template <typename T>
+T lerpInteger(T from, T to, float weight, float max) {
+    float value = lerp(static_cast<float>(from), static_cast<float>(to), weight);
+    return static_cast<T>(std::lround(std::max(0.0f, std::min(max, value))));
+}
+
+} // namespace
+
+const uint64_t G29History::kMinExtrapolationIntervalNs;
+
+G29History::G29History(size_t capacity) : slots(capacity), count(0) {
+    if (capacity < 2) {
+        throw std::invalid_argument("History must hold at least two reports");
+    }
+}
+
+void G29History::record(const G29Event& event) {
+    uint64_t index = count.load(std::memory_order_relaxed);
+    Entry entry;
+    entry.index = index;
+    entry.event = event;
+    slots[index % slots.size()].store(entry);
+    count.store(index + 1, std::memory_order_release);
+}
+
+bool G29History::read(uint64_t index, Entry& entry) const {
+    entry = slots[index % slots.size()].load();
+    return entry.index == index;
+}
+
+bool G29History::sampleAt(uint64_t timestampNs, uint64_t horizonNs, G29State& state) const {
+    uint64_t recorded = 0;
+    Entry later;
+    do {
+        // Retried only if the recorder laps the whole ring between the two loads.
+        recorded = count.load(std::memory_order_acquire);
+        if (recorded == 0) {
+            return false;
+        }
+    } while (!read(recorded - 1, later));
+
+    if (later.event.timestampNs <= timestampNs) {
+        Entry earlier;
+        uint64_t ahead = std::min(timestampNs - later.event.timestampNs, horizonNs);
+        if (ahead == 0 || recorded < 2 || !read(recorded - 2, earlier)) {
+            state = later.event.state;
+            return true;
+        }
+
+        // A burst read in one go has nearly equal timestamps; its slope would be huge.
+        uint64_t elapsed = std::max(later.event.timestampNs - earlier.event.timestampNs, kMinExtrapolationIntervalNs);
+        float interval = static_cast<float>(elapsed);
+        state = blend(earlier.event.state, later.event.state, 1.0f + static_cast<float>(ahead) / interval);
+        return true;
+    }
+
+    uint64_t oldest = recorded > slots.size() ? recorded - slots.size() : 0;
+    for (uint64_t index = recorded - 1; index > oldest; --index) {
+        Entry earlier;
+        if (!read(index - 1, earlier)) {
+            break;
+        }
+        if (earlier.event.timestampNs <= timestampNs) {
+            float interval = static_cast<float>(later.event.timestampNs - earlier.event.timestampNs);
+            float weight = interval > 0.0f ? static_cast<float>(timestampNs - earlier.event.timestampNs) / interval : 1.0f;
+            state = blend(earlier.event.state, later.event.state, weight);
+            return true;
+        }
+        later = earlier;
+    }
+
+    state = later.event.state;
+    return true;
+}
+
+uint64_t G29History::recordCount() const {
+    return count.load(std::memory_order_acquire);
+}
+
+G29State G29History::blend(const G29State& from, const G29State& to, float weight) {
+    G29State result = weight > 1.0f ? to : from;
+    result.wheel = lerpInteger(from.wheel, to.wheel, weight, 65535.0f);
+    result.throttle = lerpInteger(from.throttle, to.throttle, weight, 255.0f);
+    result.brake = lerpInteger(from.brake, to.brake, weight, 255.0f);
+    result.clutch = lerpInteger(from.clutch, to.clutch, weight, 255.0f);
+    result.steeringAxis = clampAxis(lerp(from.steeringAxis, to.steeringAxis, weight), -1.0f);
+    result.throttleAxis = clampAxis(lerp(from.throttleAxis, to.throttleAxis, weight), 0.0f);
+    result.brakeAxis = clampAxis(lerp(from.brakeAxis, to.brakeAxis, weight), 0.0f);
+    result.clutchAxis = clampAxis(lerp(from.clutchAxis, to.clutchAxis, weight), 0.0f);
+    result.steeringFiltered = clampAxis(lerp(from.steeringFiltered, to.steeringFiltered, weight), -1.0f);
+    result.throttleFiltered = clampAxis(lerp(from.throttleFiltered, to.throttleFiltered, weight), 0.0f);
+    result.brakeFiltered = clampAxis(lerp(from.brakeFiltered, to.brakeFiltered, weight), 0.0f);
+    result.clutchFiltered = clampAxis(lerp(from.clutchFiltered, to.clutchFiltered, weight), 0.0f);
+    result.steeringVelocity = lerp(from.steeringVelocity, to.steeringVelocity, std::min(weight, 1.0f));
+    result.steeringAcceleration = lerp(from.steeringAcceleration, to.steeringAcceleration, std::min(weight, 1.0f));
+    return result;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "G29State.hpp"
+#include "SeqLock.hpp"
+
+/**
+ * @class G29History
+ * @brief Ring of the most recent decoded reports, sampled at any time.
+ *
+ * One thread records reports as they are decoded; any thread can sample the
+ * state at a timestamp without blocking the recorder. Between two reports
+ * the axes are interpolated; past the newest report they are extrapolated
+ * along the last two, up to a prediction horizon.
+ */
+class G29History {
+public:
+    /**
+     * @brief Constructor for the G29History class.
+     *
+     * @param capacity The number of reports kept.
+     * @throw std::invalid_argument if capacity is less than 2.
+     */
+    explicit G29History(size_t capacity);
+
+    /**
+     * @brief Records a decoded report. Must only be called from one thread at a time.
+     *
+     * @param event The report, with timestamps that never decrease.
+     */
+    void record(const G29Event& event);
+
+    /**
+     * @brief Estimates the state at a given time.
+     *
+     * Axes are interpolated between the reports around the time, and buttons
+     * are taken from the report at or before it. Past the newest report, axes
+     * move on along the slope of the last two reports, taking the two at
+     * least kMinExtrapolationIntervalNs apart so that reports read back to
+     * back do not make a steep slope. The extrapolation stops at horizonNs
+     * past the newest report and holds there, so that the estimate does not
+     * jump when a report is late. Before the oldest report kept, the oldest
+     * state is returned.
+     *
+     * @param timestampNs The time, in steady_clock nanoseconds like G29Event::timestampNs.
+     * @param horizonNs The longest extrapolation, in nanoseconds.
+     * @param state Receives the estimate.
+     * @return false, leaving state untouched, if nothing has been recorded yet.
+     */
+    bool sampleAt(uint64_t timestampNs, uint64_t horizonNs, G29State& state) const;
+
+    /**
+     * @brief Gets the number of reports recorded so far.
+     *
+     * @return The count, including reports no longer kept.
+     */
+    uint64_t recordCount() const;
+
+    /**
+     * @brief Blends two states, with the axes interpolated or extrapolated.
+     *
+     * @param from The earlier state, returned at weight 0.
+     * @param to The later state, returned at weight 1.
+     * @param weight How far from from towards to; above 1 extrapolates.
+     * @return The blend, with axes clamped to their ranges and the
+     *         buttons and counters of from (to when extrapolating).
+     */
+    static G29State blend(const G29State& from, const G29State& to, float weight);
+
+    /// Shortest interval the extrapolation slope is taken over, as G29::kMinFilterInterval.
+    static const uint64_t kMinExtrapolationIntervalNs = 1000000;
+
+private:
+    /// One ring slot, tagged with the record number it holds.
+    struct Entry {
+        uint64_t index;
+        G29Event event;
+    };
+
+    /**
+     * @brief Reads the entry for a record number.
+     *
+     * @param index The record number.
+     * @param entry Receives the entry.
+     * @return false if the slot has since been overwritten by a newer record.
+     */
+    bool read(uint64_t index, Entry& entry) const;
+
+    std::vector<SeqLock<Entry>> slots;  ///< Ring of recent reports.
+    std::atomic<uint64_t> count;  ///< Number of reports recorded.
+};
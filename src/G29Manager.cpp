@@ -0,0 +1,243 @@
+#include "G29Manager.hpp"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+const int G29Manager::kMaxEvents;
+
+namespace {
+
+/// epoll_event::data of wakeFd, distinct from any wheel index.
+const uint64_t kWakeToken = std::numeric_limits<uint64_t>::max();
+
+/// The built-in model with the given IDs, or the G29 layout for unknown ones.
+const G29WheelModel& modelFor(unsigned short vendorId, unsigned short productId) {
+    const G29WheelModel* model = G29WheelModel::find(vendorId, productId);
+    return model ? *model : G29WheelModel::g29();
+}
+
+} // namespace
+
+G29Manager::G29Manager() : epollFd(-1), wakeFd(-1), running(false) {
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        ::close(epollFd);
+        throw std::runtime_error("Failed to create manager wake-up event");
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeToken;
+    if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0) {
+        ::close(wakeFd);
+        ::close(epollFd);
+        throw std::runtime_error("Failed to watch manager wake-up event");
+    }
+}
+
+G29Manager::~G29Manager() {
+    joinThread();
+    devices.clear();
+    ::close(wakeFd);
+    ::close(epollFd);
+}
+
+std::vector<G29DeviceInfo> G29Manager::enumerate(unsigned short vendorId, unsigned short productId) {
+    std::vector<G29DeviceInfo> found;
+    for (const std::string& path : G29HidrawTransport::find(vendorId, productId)) {
+        G29DeviceInfo info;
+        info.path = path;
+        info.serialNumber = G29HidrawTransport::serialNumber(path);
+        found.push_back(info);
+    }
+    return found;
+}
+
+size_t G29Manager::openAll(unsigned short vendorId, unsigned short productId) {
+    requireStopped("openAll()");
+
+    std::vector<G29DeviceInfo> found = enumerate(vendorId, productId);
+    for (const G29DeviceInfo& info : found) {
+        open(info.path, modelFor(vendorId, productId));
+    }
+    return found.size();
+}
+
+size_t G29Manager::openBySerial(const std::string& serialNumber, unsigned short vendorId, unsigned short productId) {
+    requireStopped("openBySerial()");
+
+    for (const G29DeviceInfo& info : enumerate(vendorId, productId)) {
+        if (info.serialNumber == serialNumber) {
+            return open(info.path, modelFor(vendorId, productId));
+        }
+    }
+    throw std::runtime_error("No G29 device with serial number " + serialNumber);
+}
+
+size_t G29Manager::open(const std::string& path, const G29WheelModel& model) {
+    requireStopped("open()");
+    return add(std::unique_ptr<G29Transport>(new G29HidrawTransport(path)), model);
+}
+
+size_t G29Manager::add(std::unique_ptr<G29Transport> transport, const G29WheelModel& model) {
+    requireStopped("add()");
+    if (!transport) {
+        throw std::invalid_argument("G29Manager needs a transport");
+    }
+
+    int fd = transport->fileDescriptor();
+    if (fd < 0) {
+        throw std::invalid_argument("G29Manager needs a transport with a file descriptor");
+    }
+
+    std::unique_ptr<Device> device(new Device());
+    device->wheel.reset(new G29(std::move(transport), model));
+    device->fd = fd;
+    device->connected = true;
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = devices.size();
+    if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        throw std::runtime_error("Failed to watch G29 device");
+    }
+
+    devices.push_back(std::move(device));
+    return devices.size() - 1;
+}
+
+size_t G29Manager::size() const {
+    return devices.size();
+}
+
+G29& G29Manager::device(size_t index) {
+    if (index >= devices.size()) {
+        throw std::out_of_range("No G29 device at this index");
+    }
+    return *devices[index]->wheel;
+}
+
+bool G29Manager::isConnected(size_t index) const {
+    if (index >= devices.size()) {
+        throw std::out_of_range("No G29 device at this index");
+    }
+    return devices[index]->connected;
+}
+
+void G29Manager::setCallback(const Callback& newCallback) {
+    requireStopped("setCallback()");
+    callback = newCallback;
+}
+
+void G29Manager::setDisconnectCallback(const DisconnectCallback& newCallback) {
+    requireStopped("setDisconnectCallback()");
+    disconnectCallback = newCallback;
+}
+
+void G29Manager::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    error = nullptr;
+    thread = std::thread(&G29Manager::run, this);
+}
+
+void G29Manager::stop() {
+    joinThread();
+    if (error) {
+        std::exception_ptr stopped = error;
+        error = nullptr;
+        std::rethrow_exception(stopped);
+    }
+}
+
+void G29Manager::joinThread() {
+    running = false;
+    if (thread.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = ::write(wakeFd, &one, sizeof(one));
+        (void)written;
+        thread.join();
+    }
+}
+
+bool G29Manager::isRunning() const {
+    return running;
+}
+
+void G29Manager::requireStopped(const char* function) const {
+    if (running) {
+        throw std::logic_error(std::string(function) + " cannot be used while the manager thread is running");
+    }
+}
+
+void G29Manager::disconnect(size_t index, const char* reason) {
+    Device& device = *devices[index];
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, device.fd, nullptr);
+    device.connected = false;
+    if (disconnectCallback) {
+        disconnectCallback(index, reason);
+    }
+}
+
+void G29Manager::run() {
+    epoll_event ready[kMaxEvents];
+
+    while (running) {
+        int count = ::epoll_wait(epollFd, ready, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = std::make_exception_ptr(std::runtime_error(std::string("epoll_wait failed: ") + std::strerror(errno)));
+            running = false;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (ready[i].data.u64 == kWakeToken) {
+                uint64_t value = 0;
+                ssize_t drained = ::read(wakeFd, &value, sizeof(value));
+                (void)drained;
+                continue;
+            }
+
+            size_t index = static_cast<size_t>(ready[i].data.u64);
+            Device& device = *devices[index];
+            if (!device.connected) {
+                continue;
+            }
+
+            try {
+                G29Batch batch = device.wheel->drain();
+                if (batch.reportCount > 0 && callback) {
+                    callback(index, batch);
+                }
+            } catch (const std::runtime_error& e) {
+                disconnect(index, e.what());
+                continue;
+            }
+
+            if (ready[i].events & (EPOLLHUP | EPOLLERR)) {
+                disconnect(index, "device hung up");
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "G29.hpp"
+
+/**
+ * @struct G29DeviceInfo
+ * @brief A wheel found by G29Manager::enumerate().
+ */
+struct G29DeviceInfo {
+    std::string path;  ///< The hidraw node, for example /dev/hidraw3.
+    std::string serialNumber;  ///< The USB serial number, empty if the device reports none.
+};
+
+/**
+ * @class G29Manager
+ * @brief Serves many wheels from a single epoll thread.
+ *
+ * Every wheel is a G29 over a transport with a pollable file descriptor,
+ * normally a G29HidrawTransport. The manager thread sleeps in epoll_wait()
+ * until one or more wheels have reports, drains each ready wheel without
+ * blocking and hands the resulting batch to the callback, so CPU usage grows
+ * with the report rate, not with the number of wheels.
+ *
+ * The wheels' own reader threads must not be started. Their force feedback
+ * and state queries can be used from any thread.
+ */
+class G29Manager {
+public:
+    /// Called from the manager thread with the index of a wheel and the reports it just decoded.
+    typedef std::function<void(size_t device, const G29Batch& batch)> Callback;
+    /// Called from the manager thread with the index of a wheel it stopped serving and why.
+    typedef std::function<void(size_t device, const std::string& reason)> DisconnectCallback;
+
+    /**
+     * @brief Constructor for the G29Manager class; starts with no wheel.
+     *
+     * @throw std::runtime_error if the epoll instance cannot be created.
+     */
+    G29Manager();
+
+    /**
+     * @brief Stops the manager thread and closes every wheel.
+     */
+    ~G29Manager();
+
+    G29Manager(const G29Manager&) = delete;
+    G29Manager& operator=(const G29Manager&) = delete;
+
+    /**
+     * @brief Lists the connected wheels, using sysfs.
+     *
+     * @param vendorId The USB vendor ID.
+     * @param productId The USB product ID.
+     * @return The wheels, sorted by hidraw node.
+     */
+    static std::vector<G29DeviceInfo> enumerate(unsigned short vendorId = 0x046d, unsigned short productId = 0xc24f);
+
+    /**
+     * @brief Opens every connected wheel.
+     *
+     * @param vendorId The USB vendor ID.
+     * @param productId The USB product ID.
+     * @return The number of wheels opened.
+     * @throw std::logic_error if the manager thread is running.
+     * @throw std::runtime_error if a wheel cannot be opened.
+     */
+    size_t openAll(unsigned short vendorId = 0x046d, unsigned short productId = 0xc24f);
+
+    /**
+     * @brief Opens the wheel with a given serial number.
+     *
+     * @param serialNumber The USB serial number.
+     * @param vendorId The USB vendor ID.
+     * @param productId The USB product ID.
+     * @return The index of the wheel.
+     * @throw std::logic_error if the manager thread is running.
+     * @throw std::runtime_error if no such wheel is connected or it cannot be opened.
+     */
+    size_t openBySerial(const std::string& serialNumber, unsigned short vendorId = 0x046d, unsigned short productId = 0xc24f);
+
+    /**
+     * @brief Opens a wheel by its hidraw node.
+     *
+     * @param path The node, for example /dev/hidraw3.
+     * @param model The wheel model behind the node.
+     * @return The index of the wheel.
+     * @throw std::logic_error if the manager thread is running.
+     * @throw std::runtime_error if the node cannot be opened.
+     */
+    size_t open(const std::string& path, const G29WheelModel& model = G29WheelModel::g29());
+
+    /**
+     * @brief Adds a wheel over any transport with a file descriptor.
+     *
+     * @param transport The transport; its fileDescriptor() must become
+     *                  readable when a report is pending.
+     * @param model The wheel model whose reports the transport delivers.
+     * @return The index of the wheel.
+     * @throw std::logic_error if the manager thread is running.
+     * @throw std::invalid_argument if transport is null or has no file descriptor.
+     */
+    size_t add(std::unique_ptr<G29Transport> transport, const G29WheelModel& model = G29WheelModel::g29());
+
+    /**
+     * @brief Gets the number of wheels.
+     *
+     * @return The wheel count.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets a wheel.
+     *
+     * @param index The index of the wheel, below size().
+     * @return The wheel.
+     * @throw std::out_of_range if index is not below size().
+     */
+    G29& device(size_t index);
+
+    /**
+     * @brief Checks if a wheel is still served.
+     *
+     * A wheel whose read fails or hangs up, for example because it was
+     * unplugged, is dropped from the manager thread, reported as disconnected
+     * and passed to the disconnect callback.
+     *
+     * @param index The index of the wheel, below size().
+     * @return true if the wheel is served, false otherwise.
+     * @throw std::out_of_range if index is not below size().
+     */
+    bool isConnected(size_t index) const;
+
+    /**
+     * @brief Sets the function called with every batch of decoded reports.
+     *
+     * @param callback The callback, run on the manager thread; it should not block.
+     * @throw std::logic_error if the manager thread is running.
+     */
+    void setCallback(const Callback& callback);
+
+    /**
+     * @brief Sets the function called when a wheel is no longer served.
+     *
+     * @param callback The callback, run on the manager thread with the reason
+     *                 the wheel was dropped.
+     * @throw std::logic_error if the manager thread is running.
+     */
+    void setDisconnectCallback(const DisconnectCallback& callback);
+
+    /**
+     * @brief Starts the manager thread.
+     *
+     * Does nothing if it is already running.
+     */
+    void start();
+
+    /**
+     * @brief Stops the manager thread and waits for it to exit.
+     *
+     * If the thread had already stopped because waiting for the wheels
+     * failed, that error is rethrown here, once.
+     *
+     * @throw std::runtime_error if the manager thread stopped on an error.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the manager thread is running.
+     *
+     * @return true if the thread is running, false otherwise.
+     */
+    bool isRunning() const;
+
+private:
+    /// A managed wheel.
+    struct Device {
+        std::unique_ptr<G29> wheel;
+        int fd;
+        std::atomic<bool> connected;
+    };
+
+    /// Maximum number of ready wheels handled per epoll_wait().
+    static const int kMaxEvents = 64;
+
+    std::vector<std::unique_ptr<Device>> devices;  ///< The wheels, by index.
+    int epollFd;  ///< Watches every wheel and wakeFd.
+    int wakeFd;  ///< eventfd signalled by stop().
+    Callback callback;  ///< Receives decoded batches.
+    DisconnectCallback disconnectCallback;  ///< Told about dropped wheels.
+    std::thread thread;  ///< The manager thread.
+    std::atomic<bool> running;  ///< Whether the manager thread should keep running.
+    std::exception_ptr error;  ///< What stopped the manager thread, until stop() rethrows it.
+
+    /**
+     * @brief Throws if the manager thread is running.
+     *
+     * @param function The name of the calling function, for the message.
+     * @throw std::logic_error if the manager thread is running.
+     */
+    void requireStopped(const char* function) const;
+
+    /**
+     * @brief Stops the manager thread without reporting its error.
+     */
+    void joinThread();
+
+    /**
+     * @brief Stops serving a wheel after it failed.
+     *
+     * @param index The index of the wheel.
+     * @param reason Why the wheel is dropped.
+     */
+    void disconnect(size_t index, const char* reason);
+
+    /**
+     * @brief Body of the manager thread.
+     */
+    void run();
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "G29ReportLayout.hpp"
+
+constexpr size_t G29ReportLayout::kReportSize;
+constexpr size_t G29ReportLayout::kWheelLow;
+constexpr size_t G29ReportLayout::kWheelHigh;
+constexpr size_t G29ReportLayout::kThrottle;
+constexpr size_t G29ReportLayout::kBrake;
+constexpr size_t G29ReportLayout::kClutch;
+constexpr size_t G29ReportLayout::kFirstButtonByte;
+constexpr size_t G29ReportLayout::kButtonByteCount;
+
+const G29ButtonEncoding G29ReportLayout::kButtons[] = {
+    {G29Button::X, 0, 0x18, 0x18},
+    {G29Button::Square, 0, 0x28, 0x28},
+    {G29Button::Triangle, 0, 0x88, 0x88},
+    {G29Button::Circle, 0, 0x48, 0x48},
+
+    {G29Button::L2, 1, 0x08, 0x08},
+    {G29Button::R2, 1, 0x04, 0x04},
+    {G29Button::L3, 1, 0x80, 0x80},
+    {G29Button::R3, 1, 0x40, 0x40},
+
+    {G29Button::DPadUp, 0, 0x0F, 0x00},  // Mask with 0x0F for directional checks
+    {G29Button::DPadDown, 0, 0x0F, 0x04},
+    {G29Button::DPadLeft, 0, 0x0F, 0x06},
+    {G29Button::DPadRight, 0, 0x0F, 0x02},
+
+    {G29Button::RotaryDialPress, 3, 0x08, 0x08},
+
+    {G29Button::PlusButton, 2, 0x80, 0x80},
+    {G29Button::MinusButton, 3, 0x01, 0x01},
+
+    {G29Button::LeftPaddle, 1, 0x02, 0x02},
+    {G29Button::RightPaddle, 1, 0x01, 0x01},
+
+    {G29Button::Share, 1, 0x10, 0x10},
+    {G29Button::Options, 1, 0x20, 0x20},
+    {G29Button::PS, 3, 0x10, 0x10},
+};
+
+const size_t G29ReportLayout::kButtonCount = sizeof(kButtons) / sizeof(kButtons[0]);
+
+// The first entry whose byte equals the value exactly wins.
+const G29ButtonEncoding G29ReportLayout::kPressedButtonOrder[] = {
+    {G29Button::X, 0, 0xFF, 0x18},
+    {G29Button::Square, 0, 0xFF, 0x28},
+    {G29Button::Triangle, 0, 0xFF, 0x88},
+    {G29Button::Circle, 0, 0xFF, 0x48},
+
+    {G29Button::L2, 1, 0xFF, 0x08},
+    {G29Button::R2, 1, 0xFF, 0x04},
+    {G29Button::L3, 1, 0xFF, 0x80},
+    {G29Button::R3, 1, 0xFF, 0x40},
+
+    {G29Button::DPadUp, 0, 0xFF, 0x00},
+    {G29Button::DPadDown, 0, 0xFF, 0x04},
+    {G29Button::DPadLeft, 0, 0xFF, 0x06},
+    {G29Button::DPadRight, 0, 0xFF, 0x02},
+
+    {G29Button::RotaryDialPress, 3, 0xFF, 0x08},
+
+    {G29Button::PlusButton, 2, 0xFF, 0x80},
+    {G29Button::MinusButton, 3, 0xFF, 0x01},
+
+    {G29Button::LeftPaddle, 1, 0xFF, 0x02},
+    {G29Button::RightPaddle, 1, 0xFF, 0x01},
+
+    {G29Button::Share, 1, 0xFF, 0x10},
+    {G29Button::Options, 1, 0xFF, 0x20},
+    {G29Button::PS, 3, 0xFF, 0x10},
+};
+
+const size_t G29ReportLayout::kPressedButtonCount = sizeof(kPressedButtonOrder) / sizeof(kPressedButtonOrder[0]);
+
+static_assert(sizeof(G29ReportLayout::kButtons) / sizeof(G29ReportLayout::kButtons[0]) == static_cast<size_t>(G29Button::Count),
+              "Every button needs an encoding");
+
+namespace {
+
+const G29WheelModel kModels[] = {
+    G29WheelModel::describe<G29ReportLayout>("Logitech G29", 0x046d, 0xc24f),
+    G29WheelModel::describe<G29ReportLayout>("Logitech G923 for PlayStation", 0x046d, 0xc266),
+};
+
+} // namespace
+
+const G29WheelModel* G29WheelModel::find(uint16_t vendorId, uint16_t productId) {
+    for (const G29WheelModel& model : kModels) {
+        if (model.vendorId == vendorId && model.productId == productId) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+const G29WheelModel* G29WheelModel::models(size_t* count) {
+    *count = sizeof(kModels) / sizeof(kModels[0]);
+    return kModels;
+}
+
+const G29WheelModel& G29WheelModel::g29() {
+    return kModels[0];
+}
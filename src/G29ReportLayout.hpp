@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "G29State.hpp"
+
+/**
+ * @struct G29ButtonEncoding
+ * @brief Where a button lives in an input report.
+ *
+ * The button is pressed when (report[byteIndex] & mask) == value.
+ */
+struct G29ButtonEncoding {
+    G29Button button;  ///< The button.
+    uint8_t byteIndex;  ///< Offset of the report byte holding the button.
+    uint8_t mask;  ///< Bits of the byte that encode the button.
+    uint8_t value;  ///< Value of those bits when the button is pressed.
+};
+
+/**
+ * @struct G29ReportLayout
+ * @brief Input report layout of the Logitech G29, also used by the G923 for PlayStation.
+ *
+ * A layout is a type whose static constants give the report offsets; it is
+ * passed to G29ReportDecoder as a template parameter, so decoding compiles to
+ * fixed loads with no branching on the wheel model. Another wheel needs a
+ * struct with the same members and an entry in the model list (see G29WheelModel).
+ */
+struct G29ReportLayout {
+    static constexpr size_t kReportSize = 16;  ///< Length of an input report.
+    static constexpr size_t kWheelLow = 4;  ///< Low byte of the 16-bit steering.
+    static constexpr size_t kWheelHigh = 5;  ///< High byte of the 16-bit steering.
+    static constexpr size_t kThrottle = 6;  ///< Throttle pedal, 255 when released.
+    static constexpr size_t kBrake = 7;  ///< Brake pedal, 255 when released.
+    static constexpr size_t kClutch = 8;  ///< Clutch pedal, 255 when released.
+    static constexpr size_t kFirstButtonByte = 0;  ///< First report byte holding buttons.
+    static constexpr size_t kButtonByteCount = 4;  ///< Number of consecutive report bytes holding buttons.
+    static const G29ButtonEncoding kButtons[];  ///< Every button, in G29Button order.
+    static const size_t kButtonCount;  ///< Number of entries in kButtons.
+    /// Whole-byte encodings G29::updateButtonState() tries in order to name a single pressed button.
+    static const G29ButtonEncoding kPressedButtonOrder[];
+    static const size_t kPressedButtonCount;  ///< Number of entries in kPressedButtonOrder.
+};
+
+/**
+ * @class G29ReportDecoder
+ * @brief Decodes the input reports of one layout.
+ *
+ * Buttons are decoded with one 256-entry lookup table per button byte, built
+ * once from the layout's encodings.
+ *
+ * @tparam Layout The report layout, such as G29ReportLayout.
+ */
+template <typename Layout>
+class G29ReportDecoder {
+public:
+    /**
+     * @brief Decodes the raw fields of a report into a state.
+     *
+     * Sets steering, wheel, throttle, brake, clutch and buttons; the
+     * normalized axes and report count are left to the caller.
+     *
+     * @param report The report, Layout::kReportSize bytes long.
+     * @param state The state to update.
+     */
+    static void decode(const uint8_t* report, G29State& state) {
+        uint8_t low = report[Layout::kWheelLow];
+        uint8_t high = report[Layout::kWheelHigh];
+        state.steering = legacySteering(low, high);
+        state.wheel = static_cast<uint16_t>(low | (high << 8));
+        state.throttle = report[Layout::kThrottle];
+        state.brake = report[Layout::kBrake];
+        state.clutch = report[Layout::kClutch];
+        state.buttons = decodeButtons(report);
+    }
+
+    /**
+     * @brief Decodes the buttons of a report into a bitmask.
+     *
+     * @param report The report.
+     * @return The pressed buttons, one bit per G29Button.
+     */
+    static uint32_t decodeButtons(const uint8_t* report) {
+        uint32_t buttons = 0;
+        for (size_t i = 0; i < Layout::kButtonByteCount; ++i) {
+            buttons |= kTables.bits[i][report[Layout::kFirstButtonByte + i]];
+        }
+        return buttons;
+    }
+
+    /**
+     * @brief Finds the single pressed button of a report.
+     *
+     * @param report The report.
+     * @return The first entry of Layout::kPressedButtonOrder that matches, or
+     *         G29Button::Count if none does.
+     */
+    static G29Button pressedButton(const uint8_t* report) {
+        for (size_t i = 0; i < Layout::kPressedButtonCount; ++i) {
+            const G29ButtonEncoding& encoding = Layout::kPressedButtonOrder[i];
+            if ((report[encoding.byteIndex] & encoding.mask) == encoding.value) {
+                return encoding.button;
+            }
+        }
+        return G29Button::Count;
+    }
+
+    /**
+     * @brief Gets the lookup table of one button byte.
+     *
+     * @param index The button byte, below Layout::kButtonByteCount.
+     * @return 256 button bitmasks, indexed by the byte value.
+     */
+    static const uint32_t* buttonTable(size_t index) {
+        return kTables.bits[index];
+    }
+
+    /**
+     * @brief Computes the 8-bit steering value kept for compatibility.
+     *
+     * @param low The low steering byte.
+     * @param high The high steering byte.
+     * @return The distance between the two bytes, or 255 if both are 0.
+     */
+    static uint8_t legacySteering(uint8_t low, uint8_t high) {
+        if (low == 0 && high == 0) {
+            return 255;
+        }
+        return low > high ? static_cast<uint8_t>(low - high) : static_cast<uint8_t>(high - low);
+    }
+
+private:
+    /// Per-byte lookup tables, so that decoding the buttons is one load and or per byte.
+    struct Tables {
+        uint32_t bits[Layout::kButtonByteCount][256];
+
+        Tables() {
+            for (size_t byte = 0; byte < Layout::kButtonByteCount; ++byte) {
+                for (unsigned value = 0; value < 256; ++value) {
+                    uint32_t mask = 0;
+                    for (size_t i = 0; i < Layout::kButtonCount; ++i) {
+                        const G29ButtonEncoding& encoding = Layout::kButtons[i];
+                        if (encoding.byteIndex == Layout::kFirstButtonByte + byte && (value & encoding.mask) == encoding.value) {
+                            mask |= buttonMask(encoding.button);
+                        }
+                    }
+                    bits[byte][value] = mask;
+                }
+            }
+        }
+    };
+
+    static const Tables kTables;
+};
+
+template <typename Layout>
+const typename G29ReportDecoder<Layout>::Tables G29ReportDecoder<Layout>::kTables;
+
+/**
+ * @struct G29WheelModel
+ * @brief A supported wheel: its USB IDs and the decoder of its report layout.
+ *
+ * The model is picked once, when a G29 is constructed; every report then goes
+ * straight to the decoder specialized for its layout.
+ */
+struct G29WheelModel {
+    const char* name;  ///< Human-readable model name.
+    uint16_t vendorId;  ///< USB vendor ID.
+    uint16_t productId;  ///< USB product ID.
+    size_t reportSize;  ///< Length of an input report.
+    void (*decode)(const uint8_t* report, G29State& state);  ///< G29ReportDecoder<Layout>::decode.
+    uint32_t (*decodeButtons)(const uint8_t* report);  ///< G29ReportDecoder<Layout>::decodeButtons.
+    G29Button (*pressedButton)(const uint8_t* report);  ///< G29ReportDecoder<Layout>::pressedButton.
+
+    /**
+     * @brief Describes a wheel with a given layout.
+     *
+     * @tparam Layout The report layout.
+     * @param name Human-readable model name.
+     * @param vendorId USB vendor ID.
+     * @param productId USB product ID.
+     * @return The model.
+     */
+    template <typename Layout>
+    static constexpr G29WheelModel describe(const char* name, uint16_t vendorId, uint16_t productId) {
+        return G29WheelModel{name, vendorId, productId, Layout::kReportSize, &G29ReportDecoder<Layout>::decode,
+                             &G29ReportDecoder<Layout>::decodeButtons, &G29ReportDecoder<Layout>::pressedButton};
+    }
+
+    /**
+     * @brief Finds a built-in model by its USB IDs.
+     *
+     * @param vendorId USB vendor ID.
+     * @param productId USB product ID.
+     * @return The model, or nullptr if it is not supported.
+     */
+    static const G29WheelModel* find(uint16_t vendorId, uint16_t productId);
+
+    /**
+     * @brief Lists the built-in models.
+     *
+     * @param count Receives the number of models.
+     * @return The models.
+     */
+    static const G29WheelModel* models(size_t* count);
+
+    /**
+     * @brief Gets the Logitech G29 model, the default of G29.
+     *
+     * @return The G29 model.
+     */
+    static const G29WheelModel& g29();
+};
@@ -0,0 +1,26 @@
+#include "G29RevLights.hpp"
+#include <stdexcept>
+
+const unsigned G29RevLights::kLedCount;
+const uint8_t G29RevLights::kAllLeds;
+
+G29RevLights::G29RevLights() : G29RevLights(1.0f / kLedCount, 1.0f) {
+}
+
+G29RevLights::G29RevLights(float firstRpm, float redlineRpm) {
+    if (!(redlineRpm > firstRpm)) {
+        throw std::invalid_argument("Redline RPM must be above the first light's RPM");
+    }
+
+    for (unsigned i = 0; i < kLedCount; ++i) {
+        thresholds[i] = firstRpm + (redlineRpm - firstRpm) * i / (kLedCount - 1);
+    }
+}
+
+uint8_t G29RevLights::pattern(float rpm) const {
+    unsigned lit = 0;
+    for (unsigned i = 0; i < kLedCount; ++i) {
+        lit += rpm >= thresholds[i];
+    }
+    return static_cast<uint8_t>((1u << lit) - 1);
+}
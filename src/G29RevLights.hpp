@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @class G29RevLights
+ * @brief Maps engine RPM to the pattern of the G29's five rev lights.
+ *
+ * The lights come on one after the other as the RPM climbs, bit 0 first:
+ * one at firstRpm and all five at redlineRpm, with evenly spaced thresholds
+ * in between. The thresholds are computed once, so pattern() is five compares.
+ */
+class G29RevLights {
+public:
+    /// Number of rev lights on the wheel.
+    static const unsigned kLedCount = 5;
+    /// Pattern with every light on.
+    static const uint8_t kAllLeds = (1 << kLedCount) - 1;
+
+    /**
+     * @brief Constructor for the G29RevLights class, for RPM given as a
+     * fraction of the redline: one more light every fifth.
+     */
+    G29RevLights();
+
+    /**
+     * @brief Constructor for the G29RevLights class.
+     *
+     * @param firstRpm The RPM at which the first light turns on.
+     * @param redlineRpm The RPM at which all lights are on.
+     * @throw std::invalid_argument if redlineRpm is not above firstRpm.
+     */
+    G29RevLights(float firstRpm, float redlineRpm);
+
+    /**
+     * @brief Gets the lights to show at an RPM.
+     *
+     * @param rpm The engine RPM.
+     * @return The pattern, one bit per light from bit 0, as for G29::setRevLights().
+     */
+    uint8_t pattern(float rpm) const;
+
+private:
+    float thresholds[kLedCount];  ///< RPM at which each light turns on, increasing.
+};
@@ -0,0 +1,98 @@
+#include "G29SharedState.hpp"
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'G', '2', '9', 'S', 'H', 'M', 0, 0};
+const uint32_t kVersion = 2;
+
+} // namespace
+
+G29SharedStatePublisher::G29SharedStatePublisher(const std::string& name) : name(name), segment(nullptr) {
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create shared memory " + name);
+    }
+
+    if (::ftruncate(fd, sizeof(G29SharedSegment)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Failed to size shared memory " + name);
+    }
+
+    void* address = ::mmap(nullptr, sizeof(G29SharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Failed to map shared memory " + name);
+    }
+
+    segment = static_cast<G29SharedSegment*>(address);
+    segment->version = kVersion;
+    segment->sampleSize = sizeof(G29Event);
+    segment->publisherPid = static_cast<uint64_t>(::getpid());
+    new (&segment->sample) SeqLock<G29Event>();
+
+    // Readers check the magic first; make it visible only once the rest is set.
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(segment->magic, kMagic, sizeof(kMagic));
+}
+
+G29SharedStatePublisher::~G29SharedStatePublisher() {
+    ::munmap(segment, sizeof(G29SharedSegment));
+    ::shm_unlink(name.c_str());
+}
+
+void G29SharedStatePublisher::publish(const G29Event& sample) {
+    segment->sample.store(sample);
+}
+
+G29SharedStateReader::G29SharedStateReader(const std::string& name) : segment(nullptr) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open shared memory " + name);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(G29SharedSegment)) {
+        ::close(fd);
+        throw std::runtime_error("Not a G29 shared state: " + name);
+    }
+
+    void* address = ::mmap(nullptr, sizeof(G29SharedSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Failed to map shared memory " + name);
+    }
+
+    segment = static_cast<const G29SharedSegment*>(address);
+    bool valid = std::memcmp(segment->magic, kMagic, sizeof(kMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || segment->version != kVersion || segment->sampleSize != sizeof(G29Event)) {
+        ::munmap(const_cast<G29SharedSegment*>(segment), sizeof(G29SharedSegment));
+        throw std::runtime_error("Not a G29 shared state: " + name);
+    }
+}
+
+G29SharedStateReader::~G29SharedStateReader() {
+    ::munmap(const_cast<G29SharedSegment*>(segment), sizeof(G29SharedSegment));
+}
+
+G29Event G29SharedStateReader::load(uint64_t* sequence) const {
+    return segment->sample.load(sequence);
+}
+
+uint64_t G29SharedStateReader::sequence() const {
+    return segment->sample.version();
+}
+
+uint64_t G29SharedStateReader::publisherPid() const {
+    return segment->publisherPid;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "G29State.hpp"
+#include "SeqLock.hpp"
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared state needs lock-free 64-bit atomics");
+
+/**
+ * @struct G29SharedSegment
+ * @brief Layout of the shared-memory segment written by G29SharedStatePublisher.
+ */
+struct G29SharedSegment {
+    char magic[8];  ///< "G29SHM" followed by two zero bytes, written last by the publisher.
+    uint32_t version;  ///< Layout version, currently 2.
+    uint32_t sampleSize;  ///< Size of one G29Event, in bytes.
+    uint64_t publisherPid;  ///< Process ID of the publisher.
+    uint8_t reserved[40];  ///< Zero, for future use.
+    SeqLock<G29Event> sample;  ///< Last decoded report, on its own cache line.
+};
+
+static_assert(offsetof(G29SharedSegment, sample) == 64, "Shared segment layout changed");
+
+/**
+ * @class G29SharedStatePublisher
+ * @brief Publishes decoded reports to a POSIX shared-memory segment.
+ *
+ * Other processes read them with G29SharedStateReader, without touching the
+ * device. Publishing is a seqlock store into the mapping: no system call and
+ * no waiting on readers. See G29::startSharedState().
+ */
+class G29SharedStatePublisher {
+public:
+    /**
+     * @brief Creates the segment and maps it.
+     *
+     * @param name The segment name, starting with a slash, for example "/g29".
+     *             An existing segment of that name is replaced.
+     * @throw std::runtime_error if the segment cannot be created or mapped.
+     */
+    explicit G29SharedStatePublisher(const std::string& name);
+
+    /**
+     * @brief Unmaps and removes the segment.
+     *
+     * Readers that still map it keep seeing the last sample.
+     */
+    ~G29SharedStatePublisher();
+
+    G29SharedStatePublisher(const G29SharedStatePublisher&) = delete;
+    G29SharedStatePublisher& operator=(const G29SharedStatePublisher&) = delete;
+
+    /**
+     * @brief Publishes a sample. Must only be called from one thread at a time.
+     *
+     * @param sample The decoded report.
+     */
+    void publish(const G29Event& sample);
+
+private:
+    std::string name;  ///< The segment name.
+    G29SharedSegment* segment;  ///< The mapped segment.
+};
+
+/**
+ * @class G29SharedStateReader
+ * @brief Maps a segment written by G29SharedStatePublisher, read-only.
+ *
+ * Reading is wait-free for the publisher and lock-free for readers: a load
+ * copies the sample straight out of the mapping and retries only if the
+ * publisher overwrote it meanwhile.
+ */
+class G29SharedStateReader {
+public:
+    /**
+     * @brief Opens and maps a segment.
+     *
+     * @param name The segment name given to the publisher.
+     * @throw std::runtime_error if the segment does not exist, cannot be
+     *        mapped, or was not written by a compatible publisher.
+     */
+    explicit G29SharedStateReader(const std::string& name);
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    ~G29SharedStateReader();
+
+    G29SharedStateReader(const G29SharedStateReader&) = delete;
+    G29SharedStateReader& operator=(const G29SharedStateReader&) = delete;
+
+    /**
+     * @brief Gets a consistent copy of the last published sample.
+     *
+     * @param sequence If non-null, receives the sequence number of the copy.
+     * @return The last sample, all zero if none was published yet.
+     */
+    G29Event load(uint64_t* sequence = nullptr) const;
+
+    /**
+     * @brief Gets the current sequence number, to poll for new samples cheaply.
+     *
+     * @return Twice the number of samples published, odd while one is being written.
+     */
+    uint64_t sequence() const;
+
+    /**
+     * @brief Gets the process ID of the publisher.
+     *
+     * @return The publisher's process ID.
+     */
+    uint64_t publisherPid() const;
+
+private:
+    const G29SharedSegment* segment;  ///< The mapped segment.
+};
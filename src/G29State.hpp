@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @enum G29Button
+ * @brief Buttons of the G29, used as bit indices into G29State::buttons.
+ */
+enum class G29Button : uint8_t {
+    X,
+    Square,
+    Triangle,
+    Circle,
+    L2,
+    R2,
+    L3,
+    R3,
+    DPadUp,
+    DPadDown,
+    DPadLeft,
+    DPadRight,
+    RotaryDialPress,
+    PlusButton,
+    MinusButton,
+    LeftPaddle,
+    RightPaddle,
+    Share,
+    Options,
+    PS,
+    Count  ///< Number of buttons, not a button.
+};
+
+/**
+ * @brief Gets the bit of a button in G29State::buttons.
+ *
+ * @param button The button.
+ * @return A mask with only the bit of the button set.
+ */
+constexpr uint32_t buttonMask(G29Button button) {
+    return uint32_t(1) << static_cast<uint8_t>(button);
+}
+
+/**
+ * @brief Gets the bits of several buttons in G29State::buttons, at compile time.
+ *
+ * @param first The first button.
+ * @param second The second button.
+ * @param rest Any further buttons.
+ * @return A mask with the bits of all the buttons set.
+ */
+template <typename... Rest>
+constexpr uint32_t buttonMask(G29Button first, G29Button second, Rest... rest) {
+    return buttonMask(first) | buttonMask(second, rest...);
+}
+
+/**
+ * @enum G29Axis
+ * @brief Analog axes of the G29.
+ */
+enum class G29Axis : uint8_t {
+    Steering,
+    Throttle,
+    Brake,
+    Clutch,
+    Count  ///< Number of axes, not an axis.
+};
+
+/**
+ * @struct G29AxisCalibration
+ * @brief How a raw axis value is turned into a normalized one.
+ *
+ * The steering maps to -1..1 with the deadzone around the center; pedals map
+ * to 0..1 with the deadzone at the released end.
+ */
+struct G29AxisCalibration {
+    uint16_t min;  ///< Raw value mapped to -1 (steering) or 0 (pedals).
+    uint16_t max;  ///< Raw value mapped to 1. Pedals use raw values up to 255.
+    float deadzone;  ///< Fraction of the output range reported as rest, from 0 to just below 1.
+    bool invert;  ///< Whether to swap the two ends of the range.
+    float curve;  ///< Response exponent applied after the deadzone; 1 is linear.
+};
+
+/**
+ * @struct G29State
+ * @brief Decoded state of the G29, with typed axes and a button bitmask.
+ *
+ * Plain data with no heap members, so it can be copied, published through a
+ * SeqLock or written to shared memory as is.
+ */
+struct G29State {
+    uint8_t steering;  ///< Steering value, as returned by G29ReportDecoder::legacySteering().
+    uint8_t throttle;  ///< Raw throttle byte, 255 when released.
+    uint8_t brake;  ///< Raw brake byte, 255 when released.
+    uint8_t clutch;  ///< Raw clutch byte, 255 when released.
+    uint32_t buttons;  ///< Pressed buttons, one bit per G29Button.
+    uint32_t reportCount;  ///< Number of reports decoded so far.
+    uint16_t wheel;  ///< Full 16-bit wheel position, from report bytes 4 (low) and 5 (high).
+    float steeringAxis;  ///< Calibrated steering, from -1 to 1.
+    float throttleAxis;  ///< Calibrated throttle, from 0 (released) to 1.
+    float brakeAxis;  ///< Calibrated brake, from 0 (released) to 1.
+    float clutchAxis;  ///< Calibrated clutch, from 0 (released) to 1.
+    float steeringFiltered;  ///< Steering after the filter stage (see G29::setFilter()).
+    float throttleFiltered;  ///< Throttle after the filter stage.
+    float brakeFiltered;  ///< Brake after the filter stage.
+    float clutchFiltered;  ///< Clutch after the filter stage.
+    float steeringVelocity;  ///< Rate of change of the filtered steering, per second; 0 without the filter stage.
+    float steeringAcceleration;  ///< Rate of change of the steering velocity, per second squared; 0 without the filter stage.
+
+    /**
+     * @brief Checks if a button is pressed in this state.
+     *
+     * @param button The button to check.
+     * @return true if the button is pressed, false otherwise.
+     */
+    bool isPressed(G29Button button) const {
+        return (buttons & buttonMask(button)) != 0;
+    }
+
+    /**
+     * @brief Gets a calibrated axis of this state.
+     *
+     * @param axis The axis.
+     * @return The calibrated value, such as brakeAxis for G29Axis::Brake.
+     */
+    float axisValue(G29Axis axis) const {
+        switch (axis) {
+        case G29Axis::Steering:
+            return steeringAxis;
+        case G29Axis::Throttle:
+            return throttleAxis;
+        case G29Axis::Brake:
+            return brakeAxis;
+        default:
+            return clutchAxis;
+        }
+    }
+};
+
+/**
+ * @struct G29AxisRange
+ * @brief Lowest and highest value an axis took over a batch of reports.
+ */
+struct G29AxisRange {
+    uint8_t min;  ///< Lowest value seen.
+    uint8_t max;  ///< Highest value seen.
+};
+
+/**
+ * @struct G29Batch
+ * @brief Result of draining every pending report in one call.
+ *
+ * Holds the latest state plus what happened in between, so that a consumer
+ * slower than the device neither lags behind nor misses short button taps.
+ */
+struct G29Batch {
+    G29State state;  ///< State after the last report of the batch.
+    uint32_t pressed;  ///< Buttons that went down at any point in the batch.
+    uint32_t released;  ///< Buttons that went up at any point in the batch.
+    G29AxisRange steering;  ///< Range of the steering value over the batch.
+    G29AxisRange throttle;  ///< Range of the throttle value over the batch.
+    G29AxisRange brake;  ///< Range of the brake value over the batch.
+    G29AxisRange clutch;  ///< Range of the clutch value over the batch.
+    uint32_t reportCount;  ///< Number of reports coalesced into this batch.
+};
+
+/**
+ * @struct G29Event
+ * @brief One decoded report, as queued by the event queue.
+ */
+struct G29Event {
+    uint64_t timestampNs;  ///< Monotonic (steady_clock) time the report was read, in nanoseconds.
+    G29State state;  ///< State after decoding the report.
+    uint32_t pressed;  ///< Buttons that went down with this report.
+    uint32_t released;  ///< Buttons that went up with this report.
+};
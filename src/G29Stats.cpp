@@ -0,0 +1,99 @@
+#include "G29Stats.hpp"
+#include <algorithm>
+#include <limits>
+
+const unsigned G29Histogram::kSubBucketBits;
+const size_t G29Histogram::kBucketCount;
+
+namespace {
+
+const uint64_t kSubBucketCount = uint64_t(1) << G29Histogram::kSubBucketBits;
+
+unsigned highestBit(uint64_t value) {
+    return 63u - static_cast<unsigned>(__builtin_clzll(value));
+}
+
+} // namespace
+
+double G29HistogramSnapshot::mean() const {
+    return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+}
+
+uint64_t G29HistogramSnapshot::percentile(double percent) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    double clamped = std::max(0.0, std::min(100.0, percent));
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(count) + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::max(min, std::min(max, G29Histogram::bucketUpperBound(i)));
+        }
+    }
+    return max;
+}
+
+G29Histogram::G29Histogram() {
+    reset();
+}
+
+size_t G29Histogram::bucketIndex(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+
+    // The top kSubBucketBits + 1 bits pick the bucket; the leading one is
+    // implied by the power of two.
+    unsigned shift = highestBit(value) - kSubBucketBits;
+    return static_cast<size_t>(((shift + 1) << kSubBucketBits) + ((value >> shift) - kSubBucketCount));
+}
+
+uint64_t G29Histogram::bucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+
+    unsigned shift = static_cast<unsigned>(index >> kSubBucketBits) - 1;
+    uint64_t subBucket = kSubBucketCount + (index & (kSubBucketCount - 1));
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void G29Histogram::record(uint64_t value) {
+    buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = min.load(std::memory_order_relaxed);
+    while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+G29HistogramSnapshot G29Histogram::snapshot() const {
+    G29HistogramSnapshot result;
+    result.buckets.resize(kBucketCount);
+    result.count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        result.count += result.buckets[i];
+    }
+
+    result.sum = sum.load(std::memory_order_relaxed);
+    result.max = max.load(std::memory_order_relaxed);
+    result.min = result.count ? std::min(min.load(std::memory_order_relaxed), result.max) : 0;
+    return result;
+}
+
+void G29Histogram::reset() {
+    for (std::atomic<uint64_t>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    sum.store(0, std::memory_order_relaxed);
+    min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
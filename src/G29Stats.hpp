@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct G29HistogramSnapshot
+ * @brief Copy of a G29Histogram at one point in time.
+ */
+struct G29HistogramSnapshot {
+    uint64_t count;  ///< Number of recorded values.
+    uint64_t sum;  ///< Sum of the recorded values.
+    uint64_t min;  ///< Smallest recorded value, 0 if there is none.
+    uint64_t max;  ///< Largest recorded value, 0 if there is none.
+    std::vector<uint64_t> buckets;  ///< Count per bucket, see G29Histogram::bucketIndex().
+
+    /**
+     * @brief Gets the mean of the recorded values.
+     *
+     * @return The mean, 0 if there is none.
+     */
+    double mean() const;
+
+    /**
+     * @brief Gets a percentile of the recorded values.
+     *
+     * @param percent The percentile, from 0 to 100.
+     * @return The upper bound of the bucket holding the percentile, at most
+     *         max; 0 if there is no value.
+     */
+    uint64_t percentile(double percent) const;
+};
+
+/**
+ * @class G29Histogram
+ * @brief Lock-free log-linear histogram of 64-bit values, such as durations in nanoseconds.
+ *
+ * Like an HDR histogram, every power of two is split into 16 linear buckets,
+ * so any value is kept within 6.25% with a fixed 8 KiB of counters. Recording
+ * is a few relaxed atomic operations and never allocates or blocks; any
+ * thread may record or take a snapshot at any time.
+ */
+class G29Histogram {
+public:
+    /// Number of linear buckets per power of two, as a power of two.
+    static const unsigned kSubBucketBits = 4;
+
+    /// Total number of buckets, enough for any uint64_t.
+    static const size_t kBucketCount = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+    /**
+     * @brief Constructor for the G29Histogram class; starts empty.
+     */
+    G29Histogram();
+
+    G29Histogram(const G29Histogram&) = delete;
+    G29Histogram& operator=(const G29Histogram&) = delete;
+
+    /**
+     * @brief Records a value.
+     *
+     * @param value The value.
+     */
+    void record(uint64_t value);
+
+    /**
+     * @brief Copies the histogram.
+     *
+     * Values recorded during the copy may be only partly included.
+     *
+     * @return The snapshot.
+     */
+    G29HistogramSnapshot snapshot() const;
+
+    /**
+     * @brief Empties the histogram.
+     *
+     * Values recorded during the reset may be only partly cleared.
+     */
+    void reset();
+
+    /**
+     * @brief Gets the bucket a value falls in.
+     *
+     * @param value The value.
+     * @return The bucket index, below kBucketCount.
+     */
+    static size_t bucketIndex(uint64_t value);
+
+    /**
+     * @brief Gets the largest value a bucket holds.
+     *
+     * @param index The bucket index, below kBucketCount.
+     * @return The largest value of the bucket.
+     */
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    std::atomic<uint64_t> buckets[kBucketCount];  ///< Count per bucket.
+    std::atomic<uint64_t> sum;  ///< Sum of the recorded values.
+    std::atomic<uint64_t> min;  ///< Smallest recorded value, UINT64_MAX when empty.
+    std::atomic<uint64_t> max;  ///< Largest recorded value.
+};
+
+/**
+ * @struct G29Stats
+ * @brief Latency histograms and counters of a G29, see G29::enableStats().
+ *
+ * Durations are in nanoseconds, measured with std::chrono::steady_clock.
+ */
+struct G29Stats {
+    G29HistogramSnapshot interArrival;  ///< Time between two reports read by pump().
+    G29HistogramSnapshot decode;  ///< Time to decode and publish one report.
+    G29HistogramSnapshot eventDwell;  ///< Time from reading a report to popEvents() returning its event.
+    G29HistogramSnapshot commandDwell;  ///< Time from queueing an async force feedback command to writing it.
+    G29HistogramSnapshot writeLatency;  ///< Time the transport takes to write one message.
+    uint64_t droppedEvents;  ///< Events dropped because the event queue was full.
+    uint64_t coalescedCommands;  ///< Async commands replaced before being written.
+    uint64_t suppressedWrites;  ///< Force feedback writes skipped because the wheel held the effect.
+    uint64_t coalescedReports;  ///< Reports folded into a later one by drain().
+    uint64_t malformedReports;  ///< Reports ignored because of their length.
+};
@@ -0,0 +1,301 @@
+#include "G29Transport.hpp"
+#include <hidapi/hidapi.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#ifdef __linux__
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+G29HidapiTransport::G29HidapiTransport(unsigned short vendorId, unsigned short productId) : device(nullptr) {
+    if (hid_init() != 0) {
+        throw std::runtime_error("Failed to initialize HIDAPI");
+    }
+
+    device = hid_open(vendorId, productId, nullptr);
+    if (!device) {
+        hid_exit();
+        throw std::runtime_error("Failed to open G29 device");
+    }
+}
+
+G29HidapiTransport::G29HidapiTransport(const std::string& path) : device(nullptr) {
+    if (hid_init() != 0) {
+        throw std::runtime_error("Failed to initialize HIDAPI");
+    }
+
+    device = hid_open_path(path.c_str());
+    if (!device) {
+        hid_exit();
+        throw std::runtime_error("Failed to open G29 device " + path);
+    }
+}
+
+G29HidapiTransport::~G29HidapiTransport() {
+    if (device) {
+        hid_close(device);
+    }
+    hid_exit();
+}
+
+int G29HidapiTransport::read(uint8_t* data, size_t length, int timeoutMs) {
+    return hid_read_timeout(device, data, length, timeoutMs);
+}
+
+int G29HidapiTransport::write(const uint8_t* data, size_t length) {
+    return hid_write(device, data, length);
+}
+
+#ifdef __linux__
+
+G29HidrawTransport::G29HidrawTransport(const std::string& path) : fd(-1), wakeFd(-1) {
+    fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open hidraw device " + path);
+    }
+
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to create hidraw wake-up event");
+    }
+}
+
+G29HidrawTransport::~G29HidrawTransport() {
+    ::close(wakeFd);
+    ::close(fd);
+}
+
+int G29HidrawTransport::read(uint8_t* data, size_t length, int timeoutMs) {
+    pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+
+    while (true) {
+        ssize_t bytes_read = ::read(fd, data, length);
+        if (bytes_read >= 0) {
+            return static_cast<int>(bytes_read);
+        }
+        if (errno != EAGAIN && errno != EINTR) {
+            return -1;
+        }
+        if (timeoutMs == 0) {
+            return 0;
+        }
+
+        int ready = ::poll(fds, 2, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            return -1;
+        }
+        if (ready == 0) {
+            return 0;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t value = 0;
+            ssize_t drained = ::read(wakeFd, &value, sizeof(value));
+            (void)drained;
+            return 0;
+        }
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            return -1;
+        }
+    }
+}
+
+int G29HidrawTransport::write(const uint8_t* data, size_t length) {
+    ssize_t written = ::write(fd, data, length);
+    return written < 0 ? -1 : static_cast<int>(written);
+}
+
+void G29HidrawTransport::wake() {
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+namespace {
+
+/// Gets the value of a KEY= line of a hidraw node's uevent file, empty if missing.
+std::string readUevent(const std::string& node, const char* key) {
+    std::string uevent = "/sys/class/hidraw/" + node + "/device/uevent";
+    FILE* file = std::fopen(uevent.c_str(), "r");
+    if (!file) {
+        return std::string();
+    }
+
+    std::string value;
+    size_t keyLength = std::strlen(key);
+    char line[256];
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, key, keyLength) == 0 && line[keyLength] == '=') {
+            value = line + keyLength + 1;
+            value.erase(value.find_last_not_of("\r\n") + 1);
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+} // namespace
+
+std::vector<std::string> G29HidrawTransport::find(unsigned short vendorId, unsigned short productId) {
+    // uevent holds a line such as HID_ID=0003:0000046D:0000C24F.
+    char expected[32];
+    std::snprintf(expected, sizeof(expected), ":%08X:%08X", vendorId, productId);
+
+    std::vector<std::string> paths;
+    DIR* directory = ::opendir("/sys/class/hidraw");
+    if (!directory) {
+        return paths;
+    }
+
+    while (dirent* entry = ::readdir(directory)) {
+        if (std::strncmp(entry->d_name, "hidraw", 6) != 0) {
+            continue;
+        }
+
+        std::string id = readUevent(entry->d_name, "HID_ID");
+        if (strcasestr(id.c_str(), expected) != nullptr) {
+            paths.push_back(std::string("/dev/") + entry->d_name);
+        }
+    }
+    ::closedir(directory);
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::string G29HidrawTransport::serialNumber(const std::string& path) {
+    std::string node = path.substr(path.find_last_of('/') + 1);
+    return readUevent(node, "HID_UNIQ");
+}
+
+#endif
+
+const size_t G29LoopbackTransport::kReportSize;
+
+G29LoopbackTransport::G29LoopbackTransport(size_t capacity)
+    : queue(std::max<size_t>(capacity, 1)), head(0), count(0), woken(false), dropped(0), writes(0), generating(false) {
+}
+
+G29LoopbackTransport::~G29LoopbackTransport() {
+    stopGenerator();
+}
+
+int G29LoopbackTransport::read(uint8_t* data, size_t length, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto ready = [this]() { return count > 0 || woken; };
+    if (timeoutMs < 0) {
+        readable.wait(lock, ready);
+    } else if (!readable.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready)) {
+        return 0;
+    }
+
+    if (count == 0) {
+        woken = false;
+        return 0;
+    }
+
+    const Report& report = queue[head];
+    size_t copied = std::min(length, report.size());
+    std::copy(report.begin(), report.begin() + copied, data);
+    head = (head + 1) % queue.size();
+    --count;
+
+    lock.unlock();
+    writable.notify_one();
+    return static_cast<int>(copied);
+}
+
+int G29LoopbackTransport::write(const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastWritten.assign(data, data + length);
+    ++writes;
+    return static_cast<int>(length);
+}
+
+void G29LoopbackTransport::wake() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = true;
+    }
+    readable.notify_all();
+}
+
+bool G29LoopbackTransport::inject(const Report& report) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (count == queue.size()) {
+            ++dropped;
+            return false;
+        }
+        queue[(head + count) % queue.size()] = report;
+        ++count;
+    }
+    readable.notify_one();
+    return true;
+}
+
+void G29LoopbackTransport::startGenerator(const Generator& generator, unsigned rateHz) {
+    stopGenerator();
+    generating = true;
+
+    generatorThread = std::thread([this, generator, rateHz]() {
+        Report report = {};
+        auto next = std::chrono::steady_clock::now();
+        auto period = rateHz ? std::chrono::nanoseconds(1000000000 / rateHz) : std::chrono::nanoseconds(0);
+
+        for (uint64_t index = 0; generating; ++index) {
+            generator(index, report);
+
+            if (rateHz) {
+                next += period;
+                std::this_thread::sleep_until(next);
+                inject(report);
+            } else {
+                std::unique_lock<std::mutex> lock(mutex);
+                writable.wait(lock, [this]() { return count < queue.size() || !generating; });
+                if (!generating) {
+                    break;
+                }
+                queue[(head + count) % queue.size()] = report;
+                ++count;
+                lock.unlock();
+                readable.notify_one();
+            }
+        }
+    });
+}
+
+void G29LoopbackTransport::stopGenerator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generating = false;
+    }
+    writable.notify_all();
+    if (generatorThread.joinable()) {
+        generatorThread.join();
+    }
+}
+
+uint64_t G29LoopbackTransport::droppedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped;
+}
+
+uint64_t G29LoopbackTransport::writeCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writes;
+}
+
+std::vector<uint8_t> G29LoopbackTransport::lastWrite() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastWritten;
+}
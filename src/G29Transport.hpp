@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct hid_device_;
+
+/**
+ * @class G29Transport
+ * @brief How G29 exchanges raw reports with a wheel.
+ */
+class G29Transport {
+public:
+    virtual ~G29Transport() {}
+
+    /**
+     * @brief Reads one input report.
+     *
+     * @param data Where to store the report.
+     * @param length The size of @p data, in bytes.
+     * @param timeoutMs How long to block for a report, 0 to poll, -1 to block indefinitely.
+     * @return The number of bytes read, 0 on timeout or wake-up, -1 on error.
+     */
+    virtual int read(uint8_t* data, size_t length, int timeoutMs) = 0;
+
+    /**
+     * @brief Writes one output report.
+     *
+     * @param data The report.
+     * @param length The length of the report, in bytes.
+     * @return The number of bytes written, -1 on error.
+     */
+    virtual int write(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief Makes a blocked read() return early, if the transport supports it.
+     */
+    virtual void wake() {}
+
+    /**
+     * @brief Checks if wake() interrupts a blocked read().
+     *
+     * When it does not, G29::pump() blocks in short slices instead.
+     *
+     * @return true if wake() is supported, false otherwise.
+     */
+    virtual bool canWake() const { return false; }
+
+    /**
+     * @brief Gets a file descriptor that becomes readable when a report is pending.
+     *
+     * @return The descriptor, or -1 if the transport has none.
+     */
+    virtual int fileDescriptor() const { return -1; }
+};
+
+/**
+ * @class G29HidapiTransport
+ * @brief Transport through the hidapi library.
+ */
+class G29HidapiTransport : public G29Transport {
+public:
+    /**
+     * @brief Initializes hidapi and opens the first matching device.
+     *
+     * @param vendorId The USB vendor ID.
+     * @param productId The USB product ID.
+     * @throw std::runtime_error if initialization or device opening fails.
+     */
+    G29HidapiTransport(unsigned short vendorId, unsigned short productId);
+
+    /**
+     * @brief Initializes hidapi and opens a device by its hidapi path.
+     *
+     * @param path The device path, as returned by hid_enumerate().
+     * @throw std::runtime_error if initialization or device opening fails.
+     */
+    explicit G29HidapiTransport(const std::string& path);
+
+    /**
+     * @brief Closes the device and finalizes hidapi.
+     */
+    ~G29HidapiTransport();
+
+    G29HidapiTransport(const G29HidapiTransport&) = delete;
+    G29HidapiTransport& operator=(const G29HidapiTransport&) = delete;
+
+    int read(uint8_t* data, size_t length, int timeoutMs) override;
+    int write(const uint8_t* data, size_t length) override;
+
+private:
+    hid_device_* device;  ///< Pointer to the HID device.
+};
+
+#ifdef __linux__
+
+/**
+ * @class G29HidrawTransport
+ * @brief Transport straight through a Linux /dev/hidraw node.
+ *
+ * Skips hidapi-libusb's reader thread and extra buffer copy: reads block in
+ * poll() on the device and an eventfd, so wake() is immediate.
+ */
+class G29HidrawTransport : public G29Transport {
+public:
+    /**
+     * @brief Opens a hidraw node.
+     *
+     * @param path The node, for example /dev/hidraw3.
+     * @throw std::runtime_error if the node cannot be opened.
+     */
+    explicit G29HidrawTransport(const std::string& path);
+
+    /**
+     * @brief Closes the node.
+     */
+    ~G29HidrawTransport();
+
+    G29HidrawTransport(const G29HidrawTransport&) = delete;
+    G29HidrawTransport& operator=(const G29HidrawTransport&) = delete;
+
+    int read(uint8_t* data, size_t length, int timeoutMs) override;
+    int write(const uint8_t* data, size_t length) override;
+    void wake() override;
+    bool canWake() const override { return true; }
+    int fileDescriptor() const override { return fd; }
+
+    /**
+     * @brief Lists the hidraw nodes of the matching devices, using sysfs.
+     *
+     * @param vendorId The USB vendor ID.
+     * @param productId The USB product ID.
+     * @return The node paths, sorted.
+     */
+    static std::vector<std::string> find(unsigned short vendorId, unsigned short productId);
+
+    /**
+     * @brief Gets the serial number of the device behind a hidraw node, using sysfs.
+     *
+     * @param path The node, for example /dev/hidraw3.
+     * @return The serial number, empty if the device reports none.
+     */
+    static std::string serialNumber(const std::string& path);
+
+private:
+    int fd;  ///< The hidraw node.
+    int wakeFd;  ///< eventfd signalled by wake().
+};
+
+#endif
+
+/**
+ * @class G29LoopbackTransport
+ * @brief In-memory wheel, for tests and benchmarks without hardware.
+ *
+ * Reports are queued with inject() or produced by a generator thread at a
+ * fixed rate. Writes are counted and the last one is kept. The queue is
+ * allocated once; reading and injecting do not allocate.
+ */
+class G29LoopbackTransport : public G29Transport {
+public:
+    /// Size of the reports the loopback device produces.
+    static const size_t kReportSize = 16;
+
+    /// A raw report.
+    typedef std::array<uint8_t, kReportSize> Report;
+
+    /// Fills in the report with the given sequence number.
+    typedef std::function<void(uint64_t index, Report& report)> Generator;
+
+    /**
+     * @brief Constructor for the G29LoopbackTransport class.
+     *
+     * @param capacity The number of reports the queue holds; later ones are dropped.
+     */
+    explicit G29LoopbackTransport(size_t capacity = 4096);
+
+    /**
+     * @brief Stops the generator thread.
+     */
+    ~G29LoopbackTransport();
+
+    int read(uint8_t* data, size_t length, int timeoutMs) override;
+    int write(const uint8_t* data, size_t length) override;
+    void wake() override;
+    bool canWake() const override { return true; }
+
+    /**
+     * @brief Queues a report for read().
+     *
+     * @param report The report.
+     * @return true if the report was queued, false if the queue was full.
+     */
+    bool inject(const Report& report);
+
+    /**
+     * @brief Starts a thread that injects generated reports at a fixed rate.
+     *
+     * Replaces any running generator.
+     *
+     * @param generator Called for every report, with an increasing index.
+     * @param rateHz Reports per second, or 0 to inject whenever there is room.
+     */
+    void startGenerator(const Generator& generator, unsigned rateHz);
+
+    /**
+     * @brief Stops the generator thread.
+     */
+    void stopGenerator();
+
+    /**
+     * @brief Gets the number of reports dropped because the queue was full.
+     *
+     * @return The dropped report count.
+     */
+    uint64_t droppedCount() const;
+
+    /**
+     * @brief Gets the number of writes received.
+     *
+     * @return The write count.
+     */
+    uint64_t writeCount() const;
+
+    /**
+     * @brief Gets the bytes of the last write.
+     *
+     * @return The last write, empty if there was none.
+     */
+    std::vector<uint8_t> lastWrite() const;
+
+private:
+    mutable std::mutex mutex;  ///< Guards the queue and the last write.
+    std::condition_variable readable;  ///< Signalled on inject() and wake().
+    std::condition_variable writable;  ///< Signalled when read() frees a slot.
+    std::vector<Report> queue;  ///< Ring of pending reports.
+    size_t head;  ///< Next report to read.
+    size_t count;  ///< Number of pending reports.
+    bool woken;  ///< Set by wake() until a read() returns.
+    uint64_t dropped;  ///< Reports dropped because the queue was full.
+    uint64_t writes;  ///< Number of writes received.
+    std::vector<uint8_t> lastWritten;  ///< Bytes of the last write.
+    std::thread generatorThread;  ///< Thread running the generator, if any.
+    std::atomic<bool> generating;  ///< Whether the generator thread should keep running.
+};
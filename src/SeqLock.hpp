@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @class SeqLock
+ * @brief Single-writer sequence lock holding one trivially copyable value.
+ *
+ * The writer never waits for readers. Readers copy the value out and retry
+ * only if a store overlapped the copy, so they never block the writer and
+ * never take a lock. The payload is kept in relaxed atomic words, which keeps
+ * the concurrent copy free of data races.
+ *
+ * @tparam T The stored type. Must be trivially copyable.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock() : sequence(0) {
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Publishes a new value. Must only be called from one thread at a time.
+     *
+     * @param value The value to publish.
+     */
+    void store(const T& value) {
+        uint64_t buffer[kWords] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns a consistent copy of the last published value.
+     *
+     * @param version If non-null, receives the sequence number the copy was taken at.
+     * @return The last published value.
+     */
+    T load(uint64_t* version = nullptr) const {
+        uint64_t buffer[kWords];
+        uint64_t before = 0;
+        uint64_t after = 0;
+
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        if (version) {
+            *version = before;
+        }
+
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief Gets the current sequence number.
+     *
+     * @return Twice the number of completed stores, odd while a store is in progress.
+     */
+    uint64_t version() const {
+        return sequence.load(std::memory_order_acquire);
+    }
+
+private:
+    static const size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence;  ///< Odd while a store is in progress.
+    std::atomic<uint64_t> words[kWords];  ///< Payload, copied word by word.
+};
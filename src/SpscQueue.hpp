@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2024 . All rights reserved.
+ *
+ *
+ * BOULBALAH LAHCEN MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE
+ * SUITABILITY OF THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. BOULBALAH LAHCEN
+ * SHALL NOT BE LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT
+ * OF USING, MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+ * Devlopper : BOULBALAH Lahcen
+ * Email : lahcen.boulbalah@gmail.com
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @class SpscQueue
+ * @brief Bounded single-producer/single-consumer ring buffer.
+ *
+ * The storage is allocated once in the constructor. Pushing never blocks:
+ * when the ring is full the new element is dropped and counted as an
+ * overflow. Neither side takes a lock or allocates.
+ *
+ * @tparam T The element type. Copied in and out by assignment.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief Constructor for the SpscQueue class.
+     *
+     * @param capacity The number of elements the ring holds. Must be a power of two.
+     * @throw std::invalid_argument if capacity is not a power of two.
+     */
+    explicit SpscQueue(size_t capacity)
+        : slots(capacity), mask(capacity - 1), head(0), tail(0), overflows(0) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Queue capacity must be a power of two");
+        }
+    }
+
+    /**
+     * @brief Appends an element. Must only be called from the producer thread.
+     *
+     * @param value The element to append.
+     * @return true if the element was queued, false if the queue was full.
+     */
+    bool push(const T& value) {
+        uint64_t write = tail.load(std::memory_order_relaxed);
+        if (write - head.load(std::memory_order_acquire) == slots.size()) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[write & mask] = value;
+        tail.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes up to @p maxCount elements. Must only be called from the consumer thread.
+     *
+     * @param out Where to copy the elements, oldest first.
+     * @param maxCount The maximum number of elements to remove.
+     * @return The number of elements removed.
+     */
+    size_t pop(T* out, size_t maxCount) {
+        uint64_t read = head.load(std::memory_order_relaxed);
+        uint64_t available = tail.load(std::memory_order_acquire) - read;
+        size_t count = available < maxCount ? static_cast<size_t>(available) : maxCount;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = slots[(read + i) & mask];
+        }
+        head.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Gets the number of queued elements. Exact only on the consumer thread.
+     *
+     * @return The number of queued elements.
+     */
+    size_t size() const {
+        return static_cast<size_t>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief Gets the number of elements the ring holds.
+     *
+     * @return The capacity.
+     */
+    size_t capacity() const {
+        return slots.size();
+    }
+
+    /**
+     * @brief Gets the number of elements dropped because the queue was full.
+     *
+     * @return The overflow count.
+     */
+    uint64_t overflowCount() const {
+        return overflows.load(std::memory_order_relaxed);
+    }
+
+private:
+    static const size_t kCacheLine = 64;
+
+    std::vector<T> slots;  ///< Ring storage.
+    const uint64_t mask;  ///< capacity - 1, to wrap indices.
+    char padding0[kCacheLine];  ///< Keeps the consumer index off the producer's cache line.
+    std::atomic<uint64_t> head;  ///< Next element to pop, written by the consumer.
+    char padding1[kCacheLine - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail;  ///< Next slot to push, written by the producer.
+    std::atomic<uint64_t> overflows;  ///< Elements dropped because the queue was full.
+};
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include "../src/G29.hpp"
+
+// Every allocation made through the global operator new is counted while
+// tracking is on, so the test sees heap use anywhere in the library.
+namespace {
+
+std::atomic<bool> g_tracking(false);
+std::atomic<uint64_t> g_allocations(0);
+
+void* allocate(size_t size) {
+    if (g_tracking.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+/// Counts the allocations made between construction and count().
+class AllocationCounter {
+public:
+    AllocationCounter() {
+        g_allocations = 0;
+        g_tracking = true;
+    }
+
+    ~AllocationCounter() {
+        g_tracking = false;
+    }
+
+    uint64_t count() {
+        g_tracking = false;
+        return g_allocations;
+    }
+};
+
+G29LoopbackTransport::Report makeReport(uint64_t index) {
+    G29LoopbackTransport::Report report = {};
+    report[0] = static_cast<uint8_t>((index & 1) ? 0x18 : 0x08);
+    report[1] = static_cast<uint8_t>(index >> 3);
+    report[4] = static_cast<uint8_t>(index);
+    report[5] = static_cast<uint8_t>(index >> 8);
+    report[6] = static_cast<uint8_t>(255 - index);
+    report[7] = 0xff;
+    report[8] = 0xff;
+    return report;
+}
+
+void countPress(void* context, G29Button, bool, const G29Event&) {
+    ++*static_cast<uint64_t*>(context);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+TEST(G29AllocationTest, CounterSeesAllocations) {
+    AllocationCounter counter;
+    std::unique_ptr<int> value(new int(29));
+    EXPECT_EQ(counter.count(), 1u);
+}
+
+TEST(G29AllocationTest, SteadyStateInputPathDoesNotAllocate) {
+    const uint64_t kReports = 1000000;
+    const size_t kBurst = 64;
+
+    G29LoopbackTransport* loopback = new G29LoopbackTransport(kBurst);
+    G29 wheel{std::unique_ptr<G29Transport>(loopback)};
+    wheel.enableEventQueue(2 * kBurst);
+    wheel.enableStats();
+    wheel.enableHistory();
+
+    uint64_t dispatched = 0;
+    G29Dispatcher dispatcher;
+    dispatcher.onButton(G29Button::X, G29ButtonEdge::Press, &countPress, &dispatched);
+    dispatcher.onAxisCross(G29Axis::Throttle, 0.5f, [](void* context, G29Axis, float, bool, const G29Event&) {
+        ++*static_cast<uint64_t*>(context);
+    }, &dispatched);
+    wheel.setDispatcher(&dispatcher);
+    wheel.startSharedState("/g29-alloc-test-" + std::to_string(::getpid()));
+
+    G29Event events[2 * kBurst];
+    const uint8_t raw[16] = {0x28, 0x09, 0x80, 0x10};
+
+    // Warm up, so that nothing done once per wheel is counted.
+    loopback->inject(makeReport(0));
+    wheel.readLoop();
+    wheel.popEvents(events, 2 * kBurst);
+
+    uint64_t decoded = 0;
+    uint64_t pressed = 0;
+    AllocationCounter counter;
+    for (uint64_t index = 1; index <= kReports; index += kBurst) {
+        for (size_t i = 0; i < kBurst && index + i <= kReports; ++i) {
+            loopback->inject(makeReport(index + i));
+        }
+
+        G29Batch batch = wheel.drain(std::chrono::milliseconds(0));
+        decoded += batch.reportCount;
+        wheel.popEvents(events, 2 * kBurst);
+
+        G29State state = wheel.getState();
+        pressed += wheel.sampleAt(std::chrono::steady_clock::now()).isPressed(G29Button::X);
+        pressed += state.isPressed(G29Button::X);
+        pressed += wheel.isButtonPressed(G29Button::Square);
+        pressed += wheel.getPressedButtonName()[0] != '\0';
+        wheel.processReport(raw, sizeof(raw));
+        pressed += wheel.updateButtonState(raw, sizeof(raw))[0] != '\0';
+    }
+    uint64_t allocations = counter.count();
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(decoded, kReports);
+    EXPECT_GT(pressed, 0u);
+    EXPECT_GT(dispatched, 0u);
+    EXPECT_EQ(wheel.getStats().droppedEvents, 0u);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/G29Coroutine.hpp"
+
+namespace {
+
+G29LoopbackTransport::Report makeReport(uint8_t buttons, uint8_t brake) {
+    G29LoopbackTransport::Report report = {};
+    report[0] = buttons;
+    report[5] = 0x80;
+    report[6] = 0xff;
+    report[7] = brake;
+    report[8] = 0xff;
+    return report;
+}
+
+G29Task countReports(G29InputLoop& loop, int reports, int& seen) {
+    for (int i = 0; i < reports; ++i) {
+        co_await loop.nextReport();
+        ++seen;
+    }
+}
+
+G29Task waitForX(G29InputLoop& loop, std::vector<std::string>& log) {
+    G29Event event = co_await loop.buttonPressed(G29Button::X);
+    log.push_back("X at report " + std::to_string(event.state.reportCount));
+}
+
+G29Task waitForBrake(G29InputLoop& loop, std::vector<std::string>& log) {
+    G29Event event = co_await loop.axisCrosses(G29Axis::Brake, 0.5f);
+    log.push_back("brake at report " + std::to_string(event.state.reportCount));
+    event = co_await loop.axisCrosses(G29Axis::Brake, 0.5f);
+    log.push_back("brake released at report " + std::to_string(event.state.reportCount));
+}
+
+G29Task failOnReport(G29InputLoop& loop) {
+    co_await loop.nextReport();
+    throw std::runtime_error("scripted failure");
+}
+
+} // namespace
+
+TEST(G29CoroutineTest, ResumesTasksAsReportsArrive) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 wheel{std::unique_ptr<G29Transport>(loopback)};
+    G29InputLoop loop(wheel);
+
+    std::vector<std::string> log;
+    int seen = 0;
+    G29Task counter = countReports(loop, 3, seen);
+    G29Task shift = waitForX(loop, log);
+    G29Task brake = waitForBrake(loop, log);
+    G29Task failing = failOnReport(loop);
+    EXPECT_EQ(loop.waitingCount(), 4u);
+    EXPECT_FALSE(shift.done());
+    EXPECT_THROW(shift.get(), std::logic_error);
+
+    // All read in one drain: the release must be seen against the report
+    // the press resumed on, not the state after the last report.
+    loopback->inject(makeReport(0x08, 0xff));
+    loopback->inject(makeReport(0x08, 0x20));  // Brake pressed
+    loopback->inject(makeReport(0x18, 0x20));  // X pressed
+    loopback->inject(makeReport(0x08, 0x20));
+    loopback->inject(makeReport(0x08, 0xff));  // Brake released
+    loop.run();
+
+    EXPECT_EQ(seen, 3);
+    EXPECT_TRUE(counter.done());
+    EXPECT_TRUE(shift.done());
+    EXPECT_TRUE(brake.done());
+    EXPECT_THROW(failing.get(), std::runtime_error);
+    std::vector<std::string> expected = {"brake at report 2", "X at report 3", "brake released at report 5"};
+    EXPECT_EQ(log, expected);
+    EXPECT_EQ(loop.waitingCount(), 0u);
+}
+
+TEST(G29CoroutineTest, DestroyingAWaitingTaskUnregistersIt) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 wheel{std::unique_ptr<G29Transport>(loopback)};
+    G29InputLoop loop(wheel);
+
+    std::vector<std::string> log;
+    {
+        G29Task shift = waitForX(loop, log);
+        EXPECT_EQ(loop.waitingCount(), 1u);
+    }
+    EXPECT_EQ(loop.waitingCount(), 0u);
+
+    loopback->inject(makeReport(0x18, 0xff));
+    EXPECT_EQ(loop.dispatch(), 1u);
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(loop.fileDescriptor(), -1);
+}
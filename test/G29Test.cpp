@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <hidapi/hidapi.h>
 #include "../src/G29.hpp"  
+#include "../src/G29BatchDecoder.hpp"
+#include "../src/G29EffectEngine.hpp"
+#include "../src/G29Manager.hpp"
 
 // Mock class for hid_device
 class MockHidDevice {
@@ -79,9 +85,12 @@ TEST_F(G29Test, ResetSendsResetCommand) {
     EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
     EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
     EXPECT_CALL(*g_mockHidDevice, hid_write(testing::_, testing::_, testing::_)).Times(testing::AtLeast(1));
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillRepeatedly(testing::Return(0));
 
+    // A wheel that never reports does not finish its reset, even once the sweep would have started.
     G29 g29;
-    g29.reset();
+    EXPECT_THROW(g29.reset(std::chrono::milliseconds(1500)), std::runtime_error);
 }
 
 TEST_F(G29Test, ForceFeedbackConstantSetsForce) {
@@ -114,6 +123,170 @@ TEST_F(G29Test, ForceOffTurnsOffForce) {
     g29.forceOff();
 }
 
+TEST_F(G29Test, AsyncForceFeedbackCoalescesToLatestValue) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+
+    std::mutex writtenMutex;
+    std::vector<G29Message> written;
+    EXPECT_CALL(*g_mockHidDevice, hid_write(testing::_, testing::_, testing::_))
+        .WillRepeatedly(testing::Invoke([&](hid_device*, const unsigned char* data, size_t length) {
+            G29Message message;
+            std::copy(data, data + message.size(), message.begin());
+            std::lock_guard<std::mutex> lock(writtenMutex);
+            written.push_back(message);
+            return static_cast<int>(length);
+        }));
+
+    G29 g29;
+    g29.setForceFeedbackWriteInterval(std::chrono::milliseconds(20));
+    g29.startForceFeedbackWriter();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i <= 100; ++i) {
+        g29.forceFeedbackConstantAsync(i / 100.0f);
+    }
+    g29.setAutocenterAsync(0.5f, 0.5f);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_THROW(g29.forceFeedbackConstantAsync(1.5f), std::out_of_range);
+
+    g29.stopForceFeedbackWriter();
+
+    ASSERT_FALSE(written.empty());
+    EXPECT_LT(written.size(), 101u);
+    EXPECT_GT(g29.coalescedCommandCount(), 0u);
+
+    G29Message lastConstant = {};
+    bool autocenterWritten = false;
+    for (const G29Message& message : written) {
+        if (message[0] == 0x14) {
+            lastConstant = message;
+        }
+        autocenterWritten = autocenterWritten || message == G29::makeAutocenterMessage(0.5f, 0.5f);
+    }
+    EXPECT_EQ(lastConstant, G29::makeConstantForceMessage(1.0f));
+    EXPECT_TRUE(autocenterWritten);
+}
+
+TEST_F(G29Test, EffectEngineComputesConditionForces) {
+    G29ConditionEffects effects = {};
+    effects.maxForce = 1.0f;
+    EXPECT_FLOAT_EQ(G29EffectEngine::computeForce(effects, 0.5f, 1.0f, 1.0f), 0.0f);
+
+    effects.springStiffness = 0.8f;
+    EXPECT_FLOAT_EQ(G29EffectEngine::computeForce(effects, 0.5f, 0.0f, 0.0f), -0.4f);
+    EXPECT_FLOAT_EQ(G29EffectEngine::computeForce(effects, -0.5f, 0.0f, 0.0f), 0.4f);
+
+    effects = G29ConditionEffects();
+    effects.maxForce = 1.0f;
+    effects.damping = 0.1f;
+    effects.friction = 0.2f;
+    EXPECT_FLOAT_EQ(G29EffectEngine::computeForce(effects, 0.0f, 2.0f, 0.0f), -0.4f);
+    EXPECT_FLOAT_EQ(G29EffectEngine::computeForce(effects, 0.0f, 0.0f, 0.0f), 0.0f);
+
+    effects.maxForce = 0.25f;
+    EXPECT_FLOAT_EQ(G29EffectEngine::computeForce(effects, 0.0f, 2.0f, 0.0f), -0.25f);
+
+    EXPECT_FLOAT_EQ(G29EffectEngine::toConstantForce(0.0f), 0.5f);
+    EXPECT_FLOAT_EQ(G29EffectEngine::toConstantForce(-2.0f), 0.0f);
+    EXPECT_FLOAT_EQ(G29EffectEngine::toConstantForce(1.0f), 1.0f);
+}
+
+TEST_F(G29Test, EffectEngineStreamsForces) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+    EXPECT_CALL(*g_mockHidDevice, hid_write(testing::_, testing::_, testing::_)).Times(testing::AtLeast(1));
+
+    G29 g29;
+    G29EffectEngine engine(g29);
+    G29ConditionEffects effects = {};
+    effects.springStiffness = 0.5f;
+    effects.maxForce = 1.0f;
+    engine.setEffects(effects);
+
+    engine.start(500);
+    EXPECT_TRUE(engine.isRunning());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    engine.stop();
+    EXPECT_FALSE(engine.isRunning());
+
+    G29EffectEngineStats stats = engine.getStats();
+    EXPECT_GT(stats.ticks, 5u);
+    EXPECT_GE(stats.maxJitterNs, stats.lastJitterNs);
+    EXPECT_THROW(engine.start(0), std::invalid_argument);
+}
+
+TEST(G29LoopbackTest, EffectEngineStopLeavesTheWheelNeutral) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+    G29EffectEngine engine(g29);
+    G29ConditionEffects effects = {};
+    effects.maxForce = 1.0f;
+    engine.setEffects(effects);
+    G29PeriodicEffect push = {};
+    push.waveform = G29Waveform::Constant;
+    push.magnitude = 0.6f;
+    engine.periodicEffects().start(push, std::chrono::steady_clock::now());
+
+    engine.start(500);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    engine.stop();
+    g29.stopForceFeedbackWriter();
+
+    G29Message message = G29::makeConstantForceMessage(0.5f);
+    std::vector<uint8_t> neutral(message.begin(), message.end());
+    EXPECT_GT(loopback->writeCount(), 1u);
+    EXPECT_EQ(loopback->lastWrite(), neutral);
+}
+
+TEST(G29EffectSchedulerTest, MixesTimedWaveforms) {
+    EXPECT_NEAR(G29EffectScheduler::waveformValue(G29Waveform::Sine, 0.25), 1.0f, 1e-4f);
+    EXPECT_NEAR(G29EffectScheduler::waveformValue(G29Waveform::Sine, 1.125), std::sqrt(0.5f), 1e-4f);
+    EXPECT_EQ(G29EffectScheduler::waveformValue(G29Waveform::Square, 0.49), 1.0f);
+    EXPECT_EQ(G29EffectScheduler::waveformValue(G29Waveform::Square, 0.51), -1.0f);
+    EXPECT_NEAR(G29EffectScheduler::waveformValue(G29Waveform::SawtoothUp, 0.75), 0.5f, 1e-4f);
+
+    G29EffectScheduler scheduler(2);
+    auto t0 = std::chrono::steady_clock::time_point(std::chrono::seconds(100));
+    using std::chrono::milliseconds;
+
+    G29PeriodicEffect rumble = {};
+    rumble.waveform = G29Waveform::Sine;
+    rumble.magnitude = 0.4f;
+    rumble.frequencyHz = 10.0f;
+    rumble.duration = milliseconds(1000);
+    rumble.envelope.attackTime = milliseconds(100);
+    rumble.envelope.fadeLevel = 0.0f;
+    rumble.envelope.fadeTime = milliseconds(200);
+    G29EffectScheduler::EffectId id = scheduler.start(rumble, t0);
+
+    G29PeriodicEffect push = {};
+    push.waveform = G29Waveform::Constant;
+    push.magnitude = 0.1f;
+    push.startDelay = milliseconds(500);
+    scheduler.start(push, t0);
+    EXPECT_THROW(scheduler.start(push, t0), std::length_error);
+
+    // Peak of the sine during the attack is scaled by the envelope.
+    EXPECT_NEAR(scheduler.sample(t0 + milliseconds(25)), 0.4f * 0.25f, 1e-3f);
+    EXPECT_NEAR(scheduler.sample(t0 + milliseconds(425)), 0.4f, 1e-3f);
+    EXPECT_NEAR(scheduler.sample(t0 + milliseconds(525)), 0.5f, 1e-3f);
+    EXPECT_NEAR(scheduler.sample(t0 + milliseconds(925)), 0.1f + 0.4f * 0.375f, 1e-3f);
+    EXPECT_NEAR(scheduler.sample(t0 + milliseconds(1025)), 0.1f, 1e-6f);
+
+    // The finished rumble's slot is reused.
+    rumble.duration = milliseconds(0);
+    rumble.envelope = G29Envelope();
+    G29EffectScheduler::EffectId again = scheduler.start(rumble, t0 + milliseconds(2000));
+    EXPECT_NE(again, id);
+    EXPECT_FALSE(scheduler.stop(id));
+    EXPECT_TRUE(scheduler.stop(again));
+    EXPECT_NEAR(scheduler.sample(t0 + milliseconds(2025)), 0.1f, 1e-6f);
+
+    scheduler.stopAll();
+    EXPECT_EQ(scheduler.sample(t0 + milliseconds(2025)), 0.0f);
+}
+
 TEST_F(G29Test, PumpReadsData) {
     EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
     EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_))
@@ -122,7 +295,7 @@ TEST_F(G29Test, PumpReadsData) {
     // Prepare mock data that matches the expected format
     std::vector<unsigned char> mockData(16, 0);
     // Fill mockData with appropriate test values
-    EXPECT_CALL(*g_mockHidApi, hid_read(testing::_, testing::_, testing::_))
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
         .WillOnce(testing::DoAll(
             testing::SetArrayArgument<1>(mockData.begin(), mockData.end()),
             testing::Return(static_cast<int>(mockData.size()))
@@ -137,13 +310,85 @@ TEST_F(G29Test, PumpReadsData) {
     });
 }
 
+TEST_F(G29Test, PumpBlocksWithMillisecondTimeout) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::Le(50)))
+        .WillRepeatedly(testing::Invoke([](hid_device*, unsigned char*, size_t, int milliseconds) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+            return 0;
+        }));
+
+    G29 g29;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(g29.pump(std::chrono::milliseconds(120)), 0u);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(120));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+}
+
+TEST_F(G29Test, WakeInterruptsPump) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillRepeatedly(testing::Invoke([](hid_device*, unsigned char*, size_t, int milliseconds) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+            return 0;
+        }));
+
+    G29 g29;
+    std::thread waker([&g29]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        g29.wake();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(g29.pump(10), 0u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    waker.join();
+}
+
+TEST_F(G29Test, PumpThrowsOnReadError) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillOnce(testing::Return(-1));
+
+    G29 g29;
+    EXPECT_THROW(g29.pump(std::chrono::milliseconds(10)), std::runtime_error);
+}
+
 TEST_F(G29Test, GetStateReturnsCurrentState) {
     EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
     EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
 
     G29 g29;
-    auto state = g29.getState();
+    auto state = g29.getStateMap();
     EXPECT_FALSE(state.empty());
+
+    G29State current = g29.getState();
+    EXPECT_EQ(current.steering, 255);
+    EXPECT_EQ(current.throttle, 255);
+    EXPECT_EQ(current.brake, 255);
+    EXPECT_EQ(current.clutch, 255);
+    EXPECT_EQ(current.reportCount, 0u);
+}
+
+TEST_F(G29Test, ButtonBitmaskMatchesNamedButtons) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+
+    G29 g29;
+    g29.updateButtonState({0x28, 0x09, 0x80, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00});
+
+    uint32_t expected = buttonMask(G29Button::Square) | buttonMask(G29Button::L2) | buttonMask(G29Button::RightPaddle)
+                      | buttonMask(G29Button::PlusButton) | buttonMask(G29Button::PS);
+    EXPECT_EQ(g29.getState().buttons, expected);
+
+    for (size_t i = 0; i < static_cast<size_t>(G29Button::Count); ++i) {
+        G29Button button = static_cast<G29Button>(i);
+        EXPECT_EQ(g29.isButtonPressed(button), g29.isButtonPressed(G29::buttonName(button))) << G29::buttonName(button);
+    }
+    EXPECT_FALSE(g29.isButtonPressed("NoSuchButton"));
 }
 
 TEST_F(G29Test, IsButtonPressedChecksButtonState) {
@@ -161,6 +406,1060 @@ TEST_F(G29Test, IsButtonPressedChecksButtonState) {
     EXPECT_TRUE(g29.isButtonPressed("X"));
 }
 
+TEST_F(G29Test, ReaderThreadPublishesState) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+
+    std::vector<unsigned char> mockData = {0x18, 0x00, 0x00, 0x00, 0x10, 0x30, 0x40, 0x50, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillRepeatedly(testing::DoAll(
+            testing::SetArrayArgument<1>(mockData.begin(), mockData.end()),
+            testing::Return(static_cast<int>(mockData.size()))
+        ));
+
+    G29 g29;
+    EXPECT_EQ(g29.getState().reportCount, 0u);
+
+    g29.startReader();
+    EXPECT_TRUE(g29.isReaderRunning());
+    EXPECT_THROW(g29.readLoop(), std::logic_error);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (g29.getState().reportCount == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    g29.stopReader();
+    EXPECT_FALSE(g29.isReaderRunning());
+
+    G29State state = g29.getState();
+    EXPECT_GT(state.reportCount, 0u);
+    EXPECT_EQ(state.steering, 0x20);
+    EXPECT_EQ(state.throttle, 0x40);
+    EXPECT_EQ(state.brake, 0x50);
+    EXPECT_EQ(state.clutch, 0x60);
+    EXPECT_TRUE(state.isPressed(G29Button::X));
+    EXPECT_TRUE(g29.isButtonPressed(G29Button::X));
+}
+
+TEST_F(G29Test, ReaderThreadKeepsItsReadError) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillRepeatedly(testing::Return(-1));
+
+    G29 g29;
+    g29.startReader();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (g29.isReaderRunning() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(g29.isReaderRunning());
+
+    // The error is reported once, to the caller of stopReader().
+    EXPECT_THROW(g29.stopReader(), std::runtime_error);
+    EXPECT_NO_THROW(g29.stopReader());
+}
+
+TEST_F(G29Test, DrainCoalescesPendingReports) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+
+    std::vector<unsigned char> tap = {0x18, 0x00, 0x00, 0x00, 0x10, 0x30, 0x40, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    std::vector<unsigned char> lift = {0x08, 0x00, 0x00, 0x00, 0x10, 0x40, 0x10, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    std::vector<unsigned char> last = {0x08, 0x00, 0x00, 0x00, 0x10, 0x20, 0x80, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(tap.begin(), tap.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(lift.begin(), lift.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(last.begin(), last.end()), testing::Return(16)))
+        .WillRepeatedly(testing::Return(0));
+
+    G29 g29;
+    G29Batch batch = g29.drain();
+
+    EXPECT_EQ(batch.reportCount, 3u);
+    EXPECT_TRUE((batch.pressed & buttonMask(G29Button::X)) != 0);
+    EXPECT_TRUE((batch.released & buttonMask(G29Button::X)) != 0);
+    EXPECT_FALSE(batch.state.isPressed(G29Button::X));
+    EXPECT_EQ(batch.throttle.min, 0x10);
+    EXPECT_EQ(batch.throttle.max, 0x80);
+    EXPECT_EQ(batch.steering.min, 0x10);
+    EXPECT_EQ(batch.steering.max, 0x30);
+    EXPECT_EQ(batch.state.throttle, 0x80);
+    EXPECT_EQ(g29.getState().reportCount, 3u);
+
+    batch = g29.drain();
+    EXPECT_EQ(batch.reportCount, 0u);
+    EXPECT_EQ(batch.pressed, 0u);
+    EXPECT_EQ(batch.throttle.min, 0x80);
+    EXPECT_EQ(batch.throttle.max, 0x80);
+}
+
+TEST_F(G29Test, EventQueueKeepsShortTaps) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+
+    std::vector<unsigned char> tap = {0x18, 0x00, 0x00, 0x00, 0x10, 0x30, 0x40, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    std::vector<unsigned char> lift = {0x08, 0x00, 0x00, 0x00, 0x10, 0x30, 0x40, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(tap.begin(), tap.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(lift.begin(), lift.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(tap.begin(), tap.end()), testing::Return(16)))
+        .WillRepeatedly(testing::Return(0));
+
+    G29 g29;
+    G29Event events[4];
+    EXPECT_EQ(g29.popEvents(events, 4), 0u);
+
+    g29.enableEventQueue(2);
+    g29.readLoop();
+    g29.readLoop();
+    g29.readLoop();
+
+    ASSERT_EQ(g29.popEvents(events, 4), 2u);
+    EXPECT_EQ(g29.eventOverflowCount(), 1u);
+    EXPECT_EQ(events[0].pressed, buttonMask(G29Button::X));
+    EXPECT_EQ(events[1].released, buttonMask(G29Button::X));
+    EXPECT_LE(events[0].timestampNs, events[1].timestampNs);
+    EXPECT_EQ(events[1].state.reportCount, 2u);
+    EXPECT_EQ(g29.popEvents(events, 4), 0u);
+}
+
+TEST_F(G29Test, DecodesFullResolutionSteeringAndNormalizedAxes) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillOnce(testing::Return(reinterpret_cast<hid_device*>(1)));
+
+    std::vector<unsigned char> left = {0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    std::vector<unsigned char> right = {0x08, 0x00, 0x00, 0x00, 0x34, 0xf2, 0xff, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(left.begin(), left.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(right.begin(), right.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(right.begin(), right.end()), testing::Return(16)));
+
+    G29 g29;
+    EXPECT_NEAR(g29.getState().steeringAxis, 0.0f, 1e-4f);
+    EXPECT_FLOAT_EQ(g29.getState().throttleAxis, 0.0f);
+
+    g29.readLoop();
+    G29State state = g29.getState();
+    EXPECT_EQ(state.wheel, 0x0000);
+    EXPECT_FLOAT_EQ(state.steeringAxis, -1.0f);
+    EXPECT_FLOAT_EQ(state.throttleAxis, 0.0f);
+    EXPECT_FLOAT_EQ(state.brakeAxis, 1.0f);
+    EXPECT_NEAR(state.clutchAxis, 0.5f, 0.01f);
+
+    g29.readLoop();
+    state = g29.getState();
+    EXPECT_EQ(state.wheel, 0xf234);
+    EXPECT_NEAR(state.steeringAxis, 0xf234 / 32767.5f - 1.0f, 1e-4f);
+
+    G29AxisCalibration calibration = {};
+    calibration.min = 0x4000;
+    calibration.max = 0xc000;
+    calibration.deadzone = 0.1f;
+    calibration.curve = 1.0f;
+    g29.setCalibration(G29Axis::Steering, calibration);
+    EXPECT_EQ(g29.getCalibration(G29Axis::Steering).min, 0x4000);
+
+    g29.readLoop();
+    EXPECT_FLOAT_EQ(g29.getState().steeringAxis, 1.0f);
+
+    calibration.deadzone = 1.0f;
+    EXPECT_THROW(g29.setCalibration(G29Axis::Steering, calibration), std::out_of_range);
+    calibration.deadzone = 0.0f;
+    calibration.max = 0x4000;
+    EXPECT_THROW(g29.setCalibration(G29Axis::Steering, calibration), std::invalid_argument);
+    EXPECT_THROW(g29.setCalibration(G29Axis::Brake, G29::defaultCalibration(G29Axis::Steering)), std::invalid_argument);
+    EXPECT_THROW(g29.setCalibration(G29Axis::Count, G29::defaultCalibration(G29Axis::Brake)), std::invalid_argument);
+}
+
+TEST(G29FilterTest, SmoothsAndDifferentiatesIncrementally) {
+    const float dt = 0.001f;
+
+    // Without smoothing, a ramp passes through and its slope is the velocity.
+    G29AxisFilterState plain;
+    for (int i = 0; i <= 1000; ++i) {
+        EXPECT_FLOAT_EQ(plain.update(i * 0.0005f, dt), i * 0.0005f);
+    }
+    EXPECT_NEAR(plain.velocity(), 0.5f, 1e-3f);
+    EXPECT_NEAR(plain.acceleration(), 0.0f, 1e-2f);
+
+    G29AxisFilter settings = G29AxisFilterState::defaultFilter();
+    settings.kind = G29FilterKind::Ema;
+    settings.minCutoffHz = 5.0f;
+    G29AxisFilterState ema;
+    ema.configure(settings);
+
+    settings.kind = G29FilterKind::OneEuro;
+    settings.beta = 5.0f;
+    G29AxisFilterState oneEuro;
+    oneEuro.configure(settings);
+
+    // Both trail a fast move; One-Euro opens its cutoff and trails less.
+    ema.update(0.0f, dt);
+    oneEuro.update(0.0f, dt);
+    for (int i = 1; i <= 100; ++i) {
+        ema.update(i * 0.005f, dt);
+        oneEuro.update(i * 0.005f, dt);
+    }
+    EXPECT_LT(ema.value(), 0.5f);
+    EXPECT_LT(ema.value(), oneEuro.value());
+    EXPECT_LT(oneEuro.value(), 0.5f);
+    EXPECT_GT(oneEuro.velocity(), ema.velocity());
+
+    // A zero interval restarts the filter at the input.
+    EXPECT_FLOAT_EQ(ema.update(-0.25f, 0.0f), -0.25f);
+    EXPECT_FLOAT_EQ(ema.velocity(), 0.0f);
+
+    settings = G29AxisFilterState::defaultFilter();
+    settings.deadband = 0.01f;
+    G29AxisFilterState held;
+    held.configure(settings);
+    held.update(0.5f, dt);
+    EXPECT_FLOAT_EQ(held.update(0.505f, dt), 0.5f);
+    EXPECT_FLOAT_EQ(held.update(0.52f, dt), 0.52f);
+
+    // With smoothing, the deadband gates the input, so small smoothed steps still converge.
+    settings.kind = G29FilterKind::Ema;
+    settings.minCutoffHz = 5.0f;
+    G29AxisFilterState smoothedHeld;
+    smoothedHeld.configure(settings);
+    smoothedHeld.update(0.5f, dt);
+    EXPECT_FLOAT_EQ(smoothedHeld.update(0.505f, dt), 0.5f);
+    float previous = smoothedHeld.value();
+    for (int i = 0; i < 1000; ++i) {
+        float next = smoothedHeld.update(0.52f, dt);
+        EXPECT_GE(next, previous);
+        previous = next;
+    }
+    EXPECT_NEAR(smoothedHeld.value(), 0.52f, 0.0101f);
+    EXPECT_GT(smoothedHeld.value(), 0.505f);
+    settings.kind = G29FilterKind::OneEuro;
+    settings.beta = 5.0f;
+    smoothedHeld.configure(settings);
+    smoothedHeld.update(0.5f, dt);
+    EXPECT_FLOAT_EQ(smoothedHeld.update(0.509f, dt), 0.5f);
+    EXPECT_GT(smoothedHeld.update(0.6f, dt), 0.5f);
+
+    settings.deadband = 1.0f;
+    EXPECT_THROW(held.configure(settings), std::out_of_range);
+    settings = G29AxisFilterState::defaultFilter();
+    settings.kind = G29FilterKind::Ema;
+    settings.minCutoffHz = 0.0f;
+    EXPECT_THROW(held.configure(settings), std::invalid_argument);
+}
+
+TEST(G29LoopbackTest, FilterStagePublishesFilteredAxes) {
+    G29 wheel{std::unique_ptr<G29Transport>(new G29LoopbackTransport())};
+    uint8_t report[16] = {0x08, 0x00, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff};
+
+    wheel.processReport(report, sizeof(report));
+    G29State state = wheel.getState();
+    EXPECT_FLOAT_EQ(state.steeringFiltered, state.steeringAxis);
+    EXPECT_FLOAT_EQ(state.steeringVelocity, 0.0f);
+
+    G29AxisFilter filter = G29AxisFilterState::defaultFilter();
+    filter.kind = G29FilterKind::Ema;
+    filter.minCutoffHz = 1.0f;
+    wheel.setFilter(G29Axis::Steering, filter);
+    EXPECT_EQ(wheel.getFilter(G29Axis::Steering).kind, G29FilterKind::Ema);
+    EXPECT_EQ(wheel.getFilter(G29Axis::Brake).kind, G29FilterKind::None);
+
+    wheel.processReport(report, sizeof(report));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    report[5] = 0xff;
+    report[7] = 0x00;
+    wheel.processReport(report, sizeof(report));
+
+    state = wheel.getState();
+    EXPECT_GT(state.steeringAxis, 0.99f);
+    EXPECT_GT(state.steeringFiltered, 0.0f);
+    EXPECT_LT(state.steeringFiltered, 0.5f);
+    EXPECT_GT(state.steeringVelocity, 0.0f);
+    EXPECT_FLOAT_EQ(state.brakeFiltered, state.brakeAxis);
+}
+
+TEST(G29HistoryTest, InterpolatesAndExtrapolatesToTheRequestedTime) {
+    G29History history(4);
+    G29State state = {};
+    EXPECT_FALSE(history.sampleAt(1000, 0, state));
+
+    // Steering moves 0.1 per millisecond; X is pressed from the third report.
+    for (uint64_t i = 0; i < 6; ++i) {
+        G29Event event = {};
+        event.timestampNs = 1000000 * (i + 1);
+        event.state.steeringAxis = 0.1f * i;
+        event.state.wheel = static_cast<uint16_t>(1000 * i);
+        event.state.buttons = i >= 2 ? buttonMask(G29Button::X) : 0;
+        event.state.reportCount = static_cast<uint32_t>(i + 1);
+        history.record(event);
+    }
+    EXPECT_EQ(history.recordCount(), 6u);
+
+    ASSERT_TRUE(history.sampleAt(4250000, 0, state));
+    EXPECT_NEAR(state.steeringAxis, 0.325f, 1e-5f);
+    EXPECT_EQ(state.wheel, 3250);
+    EXPECT_EQ(state.reportCount, 4u);
+    EXPECT_TRUE(state.isPressed(G29Button::X));
+
+    // Only the last four reports are kept.
+    ASSERT_TRUE(history.sampleAt(1500000, 0, state));
+    EXPECT_FLOAT_EQ(state.steeringAxis, 0.2f);
+
+    ASSERT_TRUE(history.sampleAt(6500000, 1000000, state));
+    EXPECT_NEAR(state.steeringAxis, 0.55f, 1e-5f);
+    EXPECT_EQ(state.reportCount, 6u);
+
+    // Past the horizon the estimate holds where the horizon left it.
+    ASSERT_TRUE(history.sampleAt(6500000, 400000, state));
+    EXPECT_NEAR(state.steeringAxis, 0.54f, 1e-5f);
+
+    // No jump across the horizon.
+    G29State before = {}, after = {};
+    ASSERT_TRUE(history.sampleAt(6000000 + 399999, 400000, before));
+    ASSERT_TRUE(history.sampleAt(6000000 + 400001, 400000, after));
+    EXPECT_NEAR(before.steeringAxis, after.steeringAxis, 1e-4f);
+    EXPECT_EQ(before.wheel, after.wheel);
+
+    // Extrapolation stays within the axis range.
+    G29State from = {}, to = {};
+    from.steeringAxis = 0.8f;
+    to.steeringAxis = 1.0f;
+    EXPECT_FLOAT_EQ(G29History::blend(from, to, 3.0f).steeringAxis, 1.0f);
+
+    EXPECT_THROW(G29History(1), std::invalid_argument);
+}
+
+TEST(G29HistoryTest, BackToBackReportsDoNotOvershoot) {
+    // Two reports read 10 us apart, as when a backlog is drained in one go.
+    G29History history(4);
+    G29Event event = {};
+    event.timestampNs = 1000000;
+    event.state.steeringAxis = 0.0f;
+    history.record(event);
+    event.timestampNs += 10000;
+    event.state.steeringAxis = 0.01f;
+    history.record(event);
+
+    // The slope is taken over at least 1 ms, so 1 ms ahead moves one more step.
+    G29State state = {};
+    ASSERT_TRUE(history.sampleAt(event.timestampNs + 1000000, 8000000, state));
+    EXPECT_NEAR(state.steeringAxis, 0.02f, 1e-5f);
+
+    // Equal timestamps extrapolate with the same floor instead of holding still.
+    event.state.steeringAxis = 0.02f;
+    history.record(event);
+    ASSERT_TRUE(history.sampleAt(event.timestampNs + 500000, 8000000, state));
+    EXPECT_NEAR(state.steeringAxis, 0.025f, 1e-5f);
+}
+
+TEST(G29LoopbackTest, SampleAtFollowsReportTimestamps) {
+    G29 wheel{std::unique_ptr<G29Transport>(new G29LoopbackTransport())};
+    uint8_t report[16] = {0x08, 0x00, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff};
+
+    auto now = std::chrono::steady_clock::now();
+    EXPECT_EQ(wheel.sampleAt(now).wheel, wheel.getState().wheel);
+
+    wheel.enableHistory(8);
+    auto before = std::chrono::steady_clock::now();
+    wheel.processReport(report, sizeof(report));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    report[5] = 0x90;
+    wheel.processReport(report, sizeof(report));
+    auto after = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(wheel.sampleAt(before).wheel, 0x8000);
+    EXPECT_EQ(wheel.sampleAt(after, std::chrono::microseconds(0)).wheel, 0x9000);
+    uint16_t predicted = wheel.sampleAt(after + std::chrono::milliseconds(1), std::chrono::seconds(1)).wheel;
+    EXPECT_GT(predicted, 0x9000);
+}
+
+namespace {
+
+struct Gearbox {
+    int gear = 0;
+    std::vector<std::string> log;
+
+    void shift(G29Button button, bool, const G29Event&) {
+        gear += button == G29Button::RightPaddle ? 1 : -1;
+    }
+
+    void brake(G29Axis, float threshold, bool rising, const G29Event&) {
+        log.push_back((rising ? "above " : "below ") + std::to_string(threshold).substr(0, 4));
+    }
+};
+
+void countEdge(void* context, G29Button, bool, const G29Event&) {
+    ++*static_cast<int*>(context);
+}
+
+G29Event makeEvent(uint32_t previous, uint32_t buttons, float brake) {
+    G29Event event = {};
+    event.state.buttons = buttons;
+    event.state.brakeAxis = brake;
+    event.pressed = buttons & ~previous;
+    event.released = previous & ~buttons;
+    return event;
+}
+
+} // namespace
+
+TEST(G29DispatcherTest, CallsOnlyTheHandlersOfChangedBitsAndCrossedThresholds) {
+    static_assert(buttonMask(G29Button::L2, G29Button::R2) == (buttonMask(G29Button::L2) | buttonMask(G29Button::R2)),
+                  "buttonMask() combines at compile time");
+
+    G29Dispatcher dispatcher(8);
+    Gearbox gearbox;
+    int triggers = 0;
+    dispatcher.onButton<Gearbox, &Gearbox::shift>(G29Button::RightPaddle, G29ButtonEdge::Press, &gearbox);
+    dispatcher.onButton<Gearbox, &Gearbox::shift>(G29Button::LeftPaddle, G29ButtonEdge::Press, &gearbox);
+    G29Dispatcher::SubscriptionId released = dispatcher.onButtons(buttonMask(G29Button::L2, G29Button::R2),
+                                                                  G29ButtonEdge::Release, &countEdge, &triggers);
+    dispatcher.onAxisCross<Gearbox, &Gearbox::brake>(G29Axis::Brake, 0.75f, &gearbox);
+    dispatcher.onAxisCross<Gearbox, &Gearbox::brake>(G29Axis::Brake, 0.25f, &gearbox);
+    EXPECT_EQ(dispatcher.size(), 6u);
+
+    const uint32_t right = buttonMask(G29Button::RightPaddle);
+    const uint32_t triggersDown = buttonMask(G29Button::L2, G29Button::R2);
+    dispatcher.dispatch(makeEvent(0, 0, 0.0f));
+    dispatcher.dispatch(makeEvent(0, right | triggersDown, 0.5f));
+    dispatcher.dispatch(makeEvent(right | triggersDown, 0, 1.0f));
+    dispatcher.dispatch(makeEvent(0, right, 0.1f));
+
+    EXPECT_EQ(gearbox.gear, 2);
+    EXPECT_EQ(triggers, 2);
+    std::vector<std::string> expected = {"above 0.25", "above 0.75", "below 0.75", "below 0.25"};
+    EXPECT_EQ(gearbox.log, expected);
+
+    dispatcher.unsubscribe(released);
+    EXPECT_EQ(dispatcher.size(), 4u);
+    dispatcher.dispatch(makeEvent(0, triggersDown, 0.1f));
+    dispatcher.dispatch(makeEvent(triggersDown, 0, 0.1f));
+    EXPECT_EQ(triggers, 2);
+
+    dispatcher.onButtons(triggersDown, G29ButtonEdge::Press, &countEdge, &triggers);
+    dispatcher.onButton(G29Button::X, G29ButtonEdge::Press, &countEdge, &triggers);
+    dispatcher.onButton(G29Button::PS, G29ButtonEdge::Press, &countEdge, &triggers);
+    EXPECT_THROW(dispatcher.onButton(G29Button::Share, G29ButtonEdge::Press, &countEdge, &triggers), std::length_error);
+    EXPECT_THROW(dispatcher.onButtons(0, G29ButtonEdge::Press, &countEdge, &triggers), std::invalid_argument);
+    EXPECT_THROW(dispatcher.onButton(G29Button::X, G29ButtonEdge::Press, nullptr, nullptr), std::invalid_argument);
+}
+
+TEST(G29LoopbackTest, DispatcherRunsOnTheDecodingThread) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 wheel{std::unique_ptr<G29Transport>(loopback)};
+    G29Dispatcher dispatcher;
+    int presses = 0;
+    dispatcher.onButton(G29Button::X, G29ButtonEdge::Press, &countEdge, &presses);
+    wheel.setDispatcher(&dispatcher);
+
+    G29LoopbackTransport::Report idle = {{0x08, 0x00, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff}};
+    G29LoopbackTransport::Report x = idle;
+    x[0] = 0x18;
+    loopback->inject(idle);
+    loopback->inject(x);
+    loopback->inject(idle);
+    loopback->inject(x);
+    wheel.drain(std::chrono::milliseconds(0));
+    EXPECT_EQ(presses, 2);
+
+    wheel.setDispatcher(nullptr);
+    loopback->inject(idle);
+    loopback->inject(x);
+    wheel.drain(std::chrono::milliseconds(0));
+    EXPECT_EQ(presses, 2);
+}
+
+TEST(G29BatchDecoderTest, KernelsMatchScalarDecoder) {
+    const size_t count = 1000 + 23;  // Leaves a tail for every kernel
+    std::mt19937 random(29);
+    std::vector<uint8_t> reports(count * G29BatchDecoder::kReportSize);
+    for (uint8_t& byte : reports) {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    std::vector<uint16_t> wheel(count);
+    std::vector<uint8_t> throttle(count), brake(count), clutch(count);
+    std::vector<uint32_t> buttons(count);
+    G29ReportColumns expected = {wheel.data(), throttle.data(), brake.data(), clutch.data(), buttons.data()};
+    G29BatchDecoder::decode(reports.data(), count, expected, G29DecodeKernel::Scalar);
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* report = &reports[i * G29BatchDecoder::kReportSize];
+        ASSERT_EQ(wheel[i], report[4] | (report[5] << 8));
+        ASSERT_EQ(throttle[i], report[6]);
+        ASSERT_EQ(brake[i], report[7]);
+        ASSERT_EQ(clutch[i], report[8]);
+        ASSERT_EQ(buttons[i], G29::decodeButtons(report));
+    }
+
+    G29DecodeKernel kernels[] = {G29DecodeKernel::SSE2, G29DecodeKernel::AVX2, G29DecodeKernel::Auto};
+    for (G29DecodeKernel kernel : kernels) {
+        if (!G29BatchDecoder::isSupported(kernel)) {
+            EXPECT_THROW(G29BatchDecoder::decode(reports.data(), count, expected, kernel), std::invalid_argument);
+            continue;
+        }
+
+        std::vector<uint16_t> simdWheel(count);
+        std::vector<uint8_t> simdThrottle(count), simdBrake(count), simdClutch(count);
+        std::vector<uint32_t> simdButtons(count);
+        G29ReportColumns actual = {simdWheel.data(), simdThrottle.data(), simdBrake.data(), simdClutch.data(), simdButtons.data()};
+        G29BatchDecoder::decode(reports.data(), count, actual, kernel);
+
+        EXPECT_EQ(simdWheel, wheel);
+        EXPECT_EQ(simdThrottle, throttle);
+        EXPECT_EQ(simdBrake, brake);
+        EXPECT_EQ(simdClutch, clutch);
+        EXPECT_EQ(simdButtons, buttons);
+    }
+}
+
+TEST_F(G29Test, CaptureRecordsAndReplaysReports) {
+    EXPECT_CALL(*g_mockHidApi, hid_init()).WillRepeatedly(testing::Return(0));
+    EXPECT_CALL(*g_mockHidApi, hid_open(0x046d, 0xc24f, testing::_)).WillRepeatedly(testing::Return(reinterpret_cast<hid_device*>(1)));
+    EXPECT_CALL(*g_mockHidDevice, hid_write(testing::_, testing::_, testing::_)).WillRepeatedly(testing::Return(7));
+
+    std::vector<unsigned char> first = {0x18, 0x00, 0x00, 0x00, 0x00, 0x40, 0x20, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    std::vector<unsigned char> second = {0x08, 0x00, 0x00, 0x00, 0x00, 0x90, 0x30, 0x10, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_CALL(*g_mockHidDevice, hid_read_timeout(testing::_, testing::_, testing::_, testing::_))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(first.begin(), first.end()), testing::Return(16)))
+        .WillOnce(testing::DoAll(testing::SetArrayArgument<1>(second.begin(), second.end()), testing::Return(16)))
+        .WillRepeatedly(testing::Return(0));
+
+    std::string path = testing::TempDir() + "g29_capture_test.bin";
+    G29State recorded;
+    {
+        G29 g29;
+        g29.startCapture(path, 2);
+        g29.readLoop();
+        g29.forceFeedbackConstant(0.5f);
+        g29.readLoop();
+        recorded = g29.getState();
+        g29.stopCapture();
+    }
+
+    G29Replay replay(path);
+    ASSERT_EQ(replay.size(), 2u);
+    EXPECT_EQ(replay.record(0).kind, G29RecordKind::InputReport);
+    EXPECT_EQ(replay.record(0).length, 16);
+    EXPECT_EQ(replay.record(1).kind, G29RecordKind::OutputMessage);
+    EXPECT_EQ(replay.record(1).data[0], 0x14);
+
+    G29 replayed;
+    replayed.enableEventQueue(4);
+    EXPECT_EQ(replay.play(replayed, 0.0), 1u);
+    EXPECT_EQ(replayed.getState().wheel, 0x4000);
+    G29Event event;
+    ASSERT_EQ(replayed.popEvents(&event, 1), 1u);
+    EXPECT_EQ(event.timestampNs, replay.record(0).timestampNs);
+    EXPECT_TRUE(replayed.isButtonPressed(G29Button::X));
+    EXPECT_NE(replayed.getState().wheel, recorded.wheel);
+
+    EXPECT_THROW(G29Replay(testing::TempDir() + "g29_missing_capture.bin"), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(G29LoopbackTest, DecodesInjectedReportsAndRecordsWrites) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport(4);
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+
+    G29LoopbackTransport::Report report = {{0x18, 0x00, 0x00, 0x00, 0x34, 0x12, 0x00, 0xff, 0xff}};
+    EXPECT_TRUE(loopback->inject(report));
+    g29.readLoop();
+    EXPECT_EQ(g29.getState().wheel, 0x1234);
+    EXPECT_TRUE(g29.isButtonPressed(G29Button::X));
+
+    g29.forceFeedbackConstant(1.0f);
+    EXPECT_EQ(loopback->writeCount(), 1u);
+    std::vector<uint8_t> expected = {0x14, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_EQ(loopback->lastWrite(), expected);
+
+    for (int i = 0; i < 5; ++i) {
+        loopback->inject(report);
+    }
+    EXPECT_EQ(loopback->droppedCount(), 1u);
+
+    EXPECT_THROW(G29(std::unique_ptr<G29Transport>()), std::invalid_argument);
+}
+
+namespace {
+
+// A made-up wheel whose axes and buttons sit elsewhere in the report.
+struct ShiftedLayout {
+    static constexpr size_t kReportSize = 16;
+    static constexpr size_t kWheelLow = 10;
+    static constexpr size_t kWheelHigh = 11;
+    static constexpr size_t kThrottle = 12;
+    static constexpr size_t kBrake = 13;
+    static constexpr size_t kClutch = 14;
+    static constexpr size_t kFirstButtonByte = 1;
+    static constexpr size_t kButtonByteCount = 1;
+    static const G29ButtonEncoding kButtons[];
+    static const size_t kButtonCount;
+    static const G29ButtonEncoding kPressedButtonOrder[];
+    static const size_t kPressedButtonCount;
+};
+
+const G29ButtonEncoding ShiftedLayout::kButtons[] = {
+    {G29Button::X, 1, 0x01, 0x01},
+    {G29Button::PS, 1, 0x80, 0x80},
+};
+const size_t ShiftedLayout::kButtonCount = 2;
+const G29ButtonEncoding ShiftedLayout::kPressedButtonOrder[] = {
+    {G29Button::X, 1, 0xFF, 0x01},
+    {G29Button::PS, 1, 0xFF, 0x80},
+};
+const size_t ShiftedLayout::kPressedButtonCount = 2;
+
+} // namespace
+
+TEST(G29LoopbackTest, DecodesWithTheModelsReportLayout) {
+    const G29WheelModel* g29Model = G29WheelModel::find(0x046d, 0xc24f);
+    ASSERT_NE(g29Model, nullptr);
+    EXPECT_EQ(g29Model, &G29WheelModel::g29());
+    EXPECT_NE(G29WheelModel::find(0x046d, 0xc266), nullptr);
+    EXPECT_EQ(G29WheelModel::find(0x046d, 0x0000), nullptr);
+
+    uint8_t bytes[16] = {0x18, 0x81, 0x80, 0x10, 0x34, 0x12, 0x40, 0x50, 0x60};
+    G29State expected = {};
+    G29ReportDecoder<G29ReportLayout>::decode(bytes, expected);
+    EXPECT_EQ(expected.wheel, 0x1234);
+    EXPECT_EQ(expected.steering, 0x34 - 0x12);
+    EXPECT_EQ(expected.brake, 0x50);
+    EXPECT_EQ(expected.buttons, G29::decodeButtons(bytes));
+
+    const G29WheelModel shifted = G29WheelModel::describe<ShiftedLayout>("Shifted", 0x1234, 0x5678);
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 wheel{std::unique_ptr<G29Transport>(loopback), shifted};
+    EXPECT_STREQ(wheel.getModel().name, "Shifted");
+
+    G29LoopbackTransport::Report report = {{0x00, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                            0x34, 0x12, 0x40, 0x50, 0x60}};
+    loopback->inject(report);
+    wheel.readLoop();
+    G29State state = wheel.getState();
+    EXPECT_EQ(state.wheel, 0x1234);
+    EXPECT_EQ(state.throttle, 0x40);
+    EXPECT_EQ(state.brake, 0x50);
+    EXPECT_EQ(state.clutch, 0x60);
+    EXPECT_EQ(state.buttons, buttonMask(G29Button::X) | buttonMask(G29Button::PS));
+
+    // Button names come from the model's layout too.
+    uint8_t ps[16] = {0x18, 0x80};
+    EXPECT_STREQ(wheel.updateButtonState(ps, sizeof(ps)), "PS");
+    EXPECT_EQ(wheel.getState().buttons, buttonMask(G29Button::PS));
+    EXPECT_STREQ(wheel.updateButtonState(ps, 4), "");
+}
+
+TEST(G29LoopbackTest, ForceFeedbackSkipsEffectsTheWheelHolds) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+
+    g29.forceFeedbackConstant(0.5f);
+    g29.forceFeedbackConstant(0.5f);
+    g29.setAutocenter(0.2f, 0.1f);
+    g29.setAutocenter(0.2f, 0.1f);
+    EXPECT_EQ(loopback->writeCount(), 2u);
+    EXPECT_EQ(g29.suppressedWriteCount(), 2u);
+
+    // Other slots are tracked separately.
+    g29.forceFeedbackConstant(0.5f, 1);
+    EXPECT_EQ(loopback->writeCount(), 3u);
+    std::vector<uint8_t> expected = {0x24, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_EQ(loopback->lastWrite(), expected);
+    g29.forceOff(1);
+    EXPECT_EQ(loopback->lastWrite()[0], 0x20);
+    EXPECT_THROW(g29.forceFeedbackConstant(0.5f, G29::kForceSlotCount), std::out_of_range);
+
+    // Turning every slot off forgets what they held, so the same forces are written again.
+    g29.forceOff();
+    EXPECT_EQ(loopback->writeCount(), 5u);
+    EXPECT_EQ(loopback->lastWrite()[0], 0xf0);
+    g29.forceFeedbackConstant(0.5f);
+    g29.forceOff(1);
+    EXPECT_EQ(loopback->writeCount(), 7u);
+    EXPECT_EQ(loopback->lastWrite()[0], 0x20);
+
+    g29.startForceFeedbackWriter();
+    g29.forceFeedbackConstantAsync(0.5f);
+    g29.stopForceFeedbackWriter();
+    EXPECT_EQ(loopback->writeCount(), 7u);
+
+    g29.invalidateForceFeedbackCache();
+    g29.forceFeedbackConstant(0.5f);
+    EXPECT_EQ(loopback->writeCount(), 8u);
+    EXPECT_EQ(g29.getStats().suppressedWrites, 3u);
+}
+
+TEST(G29LoopbackTest, ForceOffDropsForcesTheWriterAlreadyTook) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+    g29.setForceFeedbackWriteInterval(std::chrono::milliseconds(200));
+    g29.startForceFeedbackWriter();
+
+    g29.forceFeedbackConstantAsync(0.25f);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (loopback->writeCount() < 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // The writer takes this one and waits out the pacing interval, then forceOff() runs.
+    g29.forceFeedbackConstantAsync(0.75f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    g29.forceOff();
+    g29.stopForceFeedbackWriter();
+
+    EXPECT_EQ(loopback->writeCount(), 2u);
+    EXPECT_EQ(loopback->lastWrite()[0], 0xf0);
+
+    // Commands queued after forceOff() are written as usual.
+    g29.setForceFeedbackWriteInterval(std::chrono::milliseconds(0));
+    g29.startForceFeedbackWriter();
+    g29.forceFeedbackConstantAsync(0.75f);
+    g29.stopForceFeedbackWriter();
+    EXPECT_EQ(loopback->lastWrite()[0], 0x14);
+}
+
+TEST(G29LoopbackTest, RevLightsFollowRpmBehindForceFeedback) {
+    G29RevLights lights(4000.0f, 8000.0f);
+    EXPECT_EQ(lights.pattern(3999.0f), 0x00);
+    EXPECT_EQ(lights.pattern(4000.0f), 0x01);
+    EXPECT_EQ(lights.pattern(6000.0f), 0x07);
+    EXPECT_EQ(lights.pattern(9000.0f), G29RevLights::kAllLeds);
+    EXPECT_EQ(G29RevLights().pattern(0.5f), 0x03);
+    EXPECT_THROW(G29RevLights(8000.0f, 8000.0f), std::invalid_argument);
+
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 wheel{std::unique_ptr<G29Transport>(loopback)};
+
+    wheel.setRevLights(0x03);
+    wheel.setRevLights(0x03);
+    std::vector<uint8_t> expected = {0xf8, 0x12, 0x03, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_EQ(loopback->lastWrite(), expected);
+    EXPECT_EQ(loopback->writeCount(), 1u);
+    EXPECT_THROW(wheel.setRevLights(0x20), std::out_of_range);
+
+    // Queued together, the force goes out before the lights.
+    wheel.setRevLightRange(4000.0f, 8000.0f);
+    for (int frame = 0; frame < 1000; ++frame) {
+        wheel.setRpmAsync(7000.0f + frame % 10);
+    }
+    wheel.forceFeedbackConstantAsync(0.25f);
+    EXPECT_EQ(wheel.coalescedCommandCount(), 0u);
+
+    wheel.startForceFeedbackWriter();
+    wheel.stopForceFeedbackWriter();
+    EXPECT_EQ(loopback->writeCount(), 3u);
+    expected = {0xf8, 0x12, 0x0f, 0x00, 0x00, 0x00, 0x00};
+    EXPECT_EQ(loopback->lastWrite(), expected);
+
+    wheel.startForceFeedbackWriter();
+    wheel.setRpmAsync(7500.0f);
+    wheel.stopForceFeedbackWriter();
+    EXPECT_EQ(loopback->writeCount(), 3u);
+}
+
+TEST(G29LoopbackTest, RevLightsAreNotStarvedByAForceStream) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 wheel{std::unique_ptr<G29Transport>(loopback)};
+    std::string path = testing::TempDir() + "g29_rev_lights_capture.bin";
+    wheel.startCapture(path, 1024);
+    wheel.setForceFeedbackWriteInterval(std::chrono::milliseconds(1));
+    wheel.startForceFeedbackWriter();
+
+    // A force every 100 us keeps a force command pending at every write.
+    wheel.setRevLightsAsync(0x1f);
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+    for (int i = 0; std::chrono::steady_clock::now() < end; ++i) {
+        wheel.forceFeedbackConstantAsync(i % 2 == 0 ? 0.25f : 0.75f);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    wheel.stopForceFeedbackWriter();
+    wheel.stopCapture();
+
+    // The lights went out while the forces were still streaming.
+    G29Replay replay(path);
+    size_t lights = replay.size();
+    size_t lastForce = 0;
+    for (size_t i = 0; i < replay.size(); ++i) {
+        const G29CaptureRecord& record = replay.record(i);
+        if (record.data[0] == 0xf8 && lights == replay.size()) {
+            lights = i;
+        } else if (record.data[0] == 0x14) {
+            lastForce = i;
+        }
+    }
+    EXPECT_LT(lights, lastForce);
+    std::remove(path.c_str());
+}
+
+TEST(G29LoopbackTest, WakeInterruptsBlockingRead) {
+    G29 g29{std::unique_ptr<G29Transport>(new G29LoopbackTransport())};
+
+    std::thread waker([&g29]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        g29.wake();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(g29.pump(std::chrono::milliseconds(10000)), 0u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    waker.join();
+}
+
+TEST(G29LoopbackTest, GeneratorFeedsReaderThread) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+
+    loopback->startGenerator([](uint64_t index, G29LoopbackTransport::Report& report) {
+        report.fill(0);
+        report[4] = static_cast<uint8_t>(index);
+        report[7] = 0xff;
+    }, 1000);
+    g29.startReader();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (g29.getState().reportCount < 20 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    g29.stopReader();
+    loopback->stopGenerator();
+
+    EXPECT_GE(g29.getState().reportCount, 20u);
+}
+
+TEST(G29LoopbackTest, ResetCompletesWhenSteeringSettles) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+
+    // Sweep back and forth for 400 ms, then rest at the center.
+    loopback->startGenerator([](uint64_t index, G29LoopbackTransport::Report& report) {
+        uint16_t wheel = index < 400 ? static_cast<uint16_t>((index % 100) * 600) : 0x8000;
+        report.fill(0);
+        report[4] = static_cast<uint8_t>(wheel);
+        report[5] = static_cast<uint8_t>(wheel >> 8);
+    }, 1000);
+
+    auto start = std::chrono::steady_clock::now();
+    std::future<bool> ready = g29.resetAsync();
+    EXPECT_THROW(g29.connectAsync(), std::logic_error);
+    EXPECT_TRUE(ready.get());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    loopback->stopGenerator();
+
+    EXPECT_GE(elapsed, std::chrono::milliseconds(400));
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_EQ(loopback->writeCount(), 2u);
+    EXPECT_EQ(g29.getState().wheel, 0x8000);
+
+    EXPECT_FALSE(g29.connectAsync(std::chrono::milliseconds(50)).get());
+    EXPECT_THROW(g29.connect(std::chrono::milliseconds(50)), std::runtime_error);
+}
+
+TEST(G29LoopbackTest, ResetDoesNotTakeAnOffCentreRestForTheSweep) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+
+    // The wheel rests a quarter turn off centre and never sweeps.
+    loopback->startGenerator([](uint64_t, G29LoopbackTransport::Report& report) {
+        report.fill(0);
+        report[5] = 0x40;
+    }, 1000);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(g29.resetAsync().get());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    loopback->stopGenerator();
+
+    // Ready only once the sweep had time to start, not a settle time after the first report.
+    EXPECT_GE(elapsed, std::chrono::milliseconds(1000));
+    EXPECT_EQ(g29.getState().wheel, 0x4000);
+}
+
+TEST(G29LoopbackTest, SharedStateReachesReaders) {
+    const std::string name = "/g29-test-" + std::to_string(::getpid());
+    G29 g29{std::unique_ptr<G29Transport>(new G29LoopbackTransport())};
+    g29.startSharedState(name);
+
+    G29SharedStateReader reader(name);
+    EXPECT_EQ(reader.publisherPid(), static_cast<uint64_t>(::getpid()));
+    EXPECT_EQ(reader.sequence(), 0u);
+
+    uint8_t report[16] = {0x18, 0x00, 0x00, 0x00, 0x34, 0x12, 0x00, 0xff, 0xff};
+    g29.processReport(report, sizeof(report));
+
+    uint64_t sequence = 0;
+    G29Event sample = reader.load(&sequence);
+    EXPECT_EQ(sequence, 2u);
+    EXPECT_EQ(sample.state.wheel, 0x1234);
+    EXPECT_EQ(sample.pressed, buttonMask(G29Button::X));
+    EXPECT_GT(sample.timestampNs, 0u);
+
+    g29.stopSharedState();
+    EXPECT_THROW(G29SharedStateReader{name}, std::runtime_error);
+}
+
+TEST(G29HistogramTest, BucketsBoundRelativeError) {
+    for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        size_t index = G29Histogram::bucketIndex(value);
+        ASSERT_LT(index, G29Histogram::kBucketCount);
+        uint64_t upper = G29Histogram::bucketUpperBound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / 16);
+        if (index > 0) {
+            EXPECT_LT(G29Histogram::bucketUpperBound(index - 1), value);
+        }
+    }
+
+    G29Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value * 1000);
+    }
+    G29HistogramSnapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.min, 1000u);
+    EXPECT_EQ(snapshot.max, 1000000u);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 500500.0);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(50)), 500000.0, 500000.0 / 16);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(99)), 990000.0, 990000.0 / 16);
+    EXPECT_EQ(snapshot.percentile(100), 1000000u);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.snapshot().count, 0u);
+}
+
+TEST(G29LoopbackTest, StatsRecordInputAndForceFeedbackLatency) {
+    G29LoopbackTransport* loopback = new G29LoopbackTransport();
+    G29 g29{std::unique_ptr<G29Transport>(loopback)};
+    g29.enableEventQueue(16);
+    g29.enableStats();
+
+    G29LoopbackTransport::Report report = {{0x18, 0x00, 0x00, 0x00, 0x34, 0x12, 0x00, 0xff, 0xff}};
+    for (int i = 0; i < 3; ++i) {
+        loopback->inject(report);
+    }
+    EXPECT_EQ(g29.drain().reportCount, 3u);
+    uint8_t shortReport[4] = {};
+    g29.processReport(shortReport, sizeof(shortReport));
+
+    G29Event events[4];
+    EXPECT_EQ(g29.popEvents(events, 4), 3u);
+
+    g29.startForceFeedbackWriter();
+    g29.forceFeedbackConstantAsync(0.5f);
+    g29.stopForceFeedbackWriter();
+
+    G29Stats stats = g29.getStats();
+    EXPECT_EQ(stats.interArrival.count, 2u);
+    EXPECT_EQ(stats.decode.count, 3u);
+    EXPECT_EQ(stats.eventDwell.count, 3u);
+    EXPECT_EQ(stats.commandDwell.count, 1u);
+    EXPECT_EQ(stats.writeLatency.count, 1u);
+    EXPECT_EQ(stats.coalescedReports, 2u);
+    EXPECT_EQ(stats.malformedReports, 1u);
+    EXPECT_EQ(stats.droppedEvents, 0u);
+    EXPECT_GT(stats.eventDwell.max, 0u);
+}
+
+#ifdef __linux__
+TEST(G29HidrawTest, MissingNodeThrows) {
+    EXPECT_THROW(G29HidrawTransport("/dev/hidraw-does-not-exist"), std::runtime_error);
+}
+
+// Wheel fed through a pipe, standing in for a hidraw node.
+class PipeTransport : public G29Transport {
+public:
+    explicit PipeTransport(int fd) : fd(fd) {}
+    ~PipeTransport() { ::close(fd); }
+
+    int read(uint8_t* data, size_t length, int) override {
+        ssize_t bytes_read = ::read(fd, data, length);
+        if (bytes_read < 0) {
+            return errno == EAGAIN ? 0 : -1;
+        }
+        return static_cast<int>(bytes_read);
+    }
+    int write(const uint8_t*, size_t length) override { return static_cast<int>(length); }
+    int fileDescriptor() const override { return fd; }
+
+private:
+    int fd;
+};
+
+TEST(G29ManagerTest, ServesSeveralWheelsFromOneThread) {
+    G29Manager manager;
+    int pipes[3][2];
+    for (auto& ends : pipes) {
+        ASSERT_EQ(::pipe2(ends, O_NONBLOCK), 0);
+        manager.add(std::unique_ptr<G29Transport>(new PipeTransport(ends[0])));
+    }
+    EXPECT_THROW(manager.add(std::unique_ptr<G29Transport>(new G29LoopbackTransport())), std::invalid_argument);
+    ASSERT_EQ(manager.size(), 3u);
+
+    std::atomic<uint32_t> reports[3];
+    for (auto& count : reports) {
+        count = 0;
+    }
+    manager.setCallback([&reports](size_t device, const G29Batch& batch) {
+        reports[device] += batch.reportCount;
+    });
+    std::atomic<int> dropped(-1);
+    std::string dropReason;
+    manager.setDisconnectCallback([&dropped, &dropReason](size_t device, const std::string& reason) {
+        dropReason = reason;
+        dropped = static_cast<int>(device);
+    });
+    manager.start();
+    EXPECT_THROW(manager.setDisconnectCallback(G29Manager::DisconnectCallback()), std::logic_error);
+    EXPECT_THROW(manager.setCallback(G29Manager::Callback()), std::logic_error);
+
+    for (size_t device = 0; device < 3; ++device) {
+        uint8_t report[16] = {0x18, 0x00, 0x00, 0x00, static_cast<uint8_t>(device), 0x80, 0x00, 0xff, 0xff};
+        for (size_t i = 0; i <= device; ++i) {
+            ASSERT_EQ(::write(pipes[device][1], report, sizeof(report)), 16);
+        }
+    }
+    ::close(pipes[1][1]);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((reports[2] < 3 || manager.isConnected(1)) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    manager.stop();
+
+    EXPECT_EQ(reports[0], 1u);
+    EXPECT_EQ(reports[1], 2u);
+    EXPECT_EQ(reports[2], 3u);
+    EXPECT_EQ(manager.device(2).getState().wheel, 0x8002);
+    EXPECT_TRUE(manager.isConnected(0));
+    EXPECT_FALSE(manager.isConnected(1));
+    EXPECT_EQ(dropped, 1);
+    EXPECT_FALSE(dropReason.empty());
+    EXPECT_THROW(manager.device(3), std::out_of_range);
+
+    ::close(pipes[0][1]);
+    ::close(pipes[2][1]);
+}
+
+TEST(G29PipeTest, ReadLoopIgnoresShortReads) {
+    int ends[2];
+    ASSERT_EQ(::pipe2(ends, O_NONBLOCK), 0);
+    G29 g29{std::unique_ptr<G29Transport>(new PipeTransport(ends[0]))};
+
+    uint8_t shortReport[4] = {0x18, 0x00, 0x00, 0x00};
+    ASSERT_EQ(::write(ends[1], shortReport, sizeof(shortReport)), 4);
+    g29.readLoop();
+    EXPECT_EQ(g29.getState().reportCount, 0u);
+    EXPECT_EQ(g29.getStats().malformedReports, 1u);
+
+    uint8_t report[16] = {0x18, 0x00, 0x00, 0x00, 0x34, 0x12, 0x00, 0xff, 0xff};
+    ASSERT_EQ(::write(ends[1], report, sizeof(report)), 16);
+    g29.readLoop();
+    EXPECT_EQ(g29.getState().reportCount, 1u);
+    EXPECT_EQ(g29.getState().wheel, 0x1234);
+
+    ::close(ends[1]);
+}
+#endif
+
 // // Test case: No button pressed
 // TEST_F(G29Test, NoButtonPressedReturnsEmptyString) {
 //     EXPECT_CALL(*g_mockHidApi, hid_init()).WillOnce(testing::Return(0));